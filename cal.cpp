@@ -1,9 +1,19 @@
 #include "cal.h"
 #include "collection.h"
+#include <KCalendarCore/Recurrence>
 #include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Spans edited in place are scanned linearly per query until there are this many (or 1/16 of the rows)
+constexpr int EditedSpanLimit = 32;
+}
 
 Cal::Cal(const QString &id, const QString &name, Collection *parent)
-    : QAbstractTableModel(parent), m_id(id), m_name(name), m_parent(parent)
+    : QAbstractTableModel(parent), m_id(id), m_name(name), m_parent(parent),
+      m_handle(parent ? IdTable::calendar(parent->id(), id) : IdTable::calendar(id))
 {
     qDebug() << "Cal: Created with id" << m_id << "name" << m_name;
 }
@@ -20,10 +30,40 @@ void Cal::addItem(QSharedPointer<CalendarItem> item)
         qDebug() << "Cal: Cannot add null item to" << m_id;
         return;
     }
+    const int row = rowOf(keyFor(*item));
+    if (row >= 0) {
+        replaceRow(row, item); // Reloaded item; a second row with the same id would shadow the first
+        return;
+    }
+    appendRow(item);
+    //qDebug() << "Cal: Added item" << item->id() << "to" << m_id;
+}
+
+QSharedPointer<CalendarItem> Cal::findItem(const QString &itemId) const
+{
+    const int row = rowOf(itemId);
+    return row >= 0 ? m_items.at(row) : QSharedPointer<CalendarItem>();
+}
+
+void Cal::replaceRow(int row, const QSharedPointer<CalendarItem> &item)
+{
+    unindexItem(*m_items.at(row));
+    m_items[row] = item;
+    m_display[row] = DisplayRow();
+    m_timeIndexStale = true;
+    indexItem(*item);
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+}
+
+void Cal::appendRow(const QSharedPointer<CalendarItem> &item)
+{
     beginInsertRows(QModelIndex(), m_items.size(), m_items.size());
+    m_rowById.insert(keyFor(*item), m_items.size());
     m_items.append(item);
+    m_display.append(DisplayRow());
+    m_timeIndexStale = true;
+    indexItem(*item);
     endInsertRows();
-    //qDebug() << "Cal: Added item" << item->id() << "to" << m_id;
 }
 
 void Cal::updateItem(const QSharedPointer<CalendarItem> &item)
@@ -32,18 +72,14 @@ void Cal::updateItem(const QSharedPointer<CalendarItem> &item)
         qDebug() << "Cal: Cannot update with null item in" << m_id;
         return;
     }
-    for (int i = 0; i < m_items.size(); ++i) {
-        if (m_items[i]->id() == item->id()) {
-            m_items[i] = item; // Replace with the new instance from delta
-            emit dataChanged(index(i, 0), index(i, columnCount() - 1));
-            qDebug() << "Cal: Updated item" << item->id() << "in" << m_id;
-            return;
-        }
+    const int row = rowOf(keyFor(*item));
+    if (row >= 0) {
+        replaceRow(row, item); // Replace with the new instance from delta
+        qDebug() << "Cal: Updated item" << item->id() << "in" << m_id;
+        return;
     }
     // If not found, add it (could be a new item not in .ics yet)
-    beginInsertRows(QModelIndex(), m_items.size(), m_items.size());
-    m_items.append(item);
-    endInsertRows();
+    appendRow(item);
     qDebug() << "Cal: Added missing item" << item->id() << "to" << m_id << "during update";
 }
 
@@ -53,16 +89,406 @@ void Cal::removeItem(const QSharedPointer<CalendarItem> &item)
         qDebug() << "Cal: Cannot remove null item from" << m_id;
         return;
     }
-    for (int i = 0; i < m_items.size(); ++i) {
-        if (m_items[i]->id() == item->id()) {
-            beginRemoveRows(QModelIndex(), i, i);
-            m_items.removeAt(i);
-            endRemoveRows();
-            qDebug() << "Cal: Removed item" << item->id() << "from" << m_id;
-            return;
+    const IdTable::Id key = keyFor(*item);
+    const int row = rowOf(key);
+    if (row < 0) {
+        qDebug() << "Cal: Item" << item->id() << "not found for removal in" << m_id;
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_items.removeAt(row);
+    m_display.removeAt(row);
+    unindexItem(*item);
+    m_rowById.remove(key);
+    m_occurrences.remove(key);
+    reindexFrom(row); // Rows below the removed one moved up by one
+    m_timeIndexStale = true;
+    endRemoveRows();
+    qDebug() << "Cal: Removed item" << item->id() << "from" << m_id;
+}
+
+void Cal::addItems(const QList<QSharedPointer<CalendarItem>> &items)
+{
+    mergeItems(items);
+}
+
+void Cal::updateItems(const QList<QSharedPointer<CalendarItem>> &items)
+{
+    mergeItems(items); // Same upsert as addItems; kept separate so call sites read like their single-item forms
+}
+
+void Cal::mergeItems(const QList<QSharedPointer<CalendarItem>> &items)
+{
+    QList<QSharedPointer<CalendarItem>> appended;
+    QHash<IdTable::Id, int> appendedIndex; // A batch may carry the same id twice; the later copy wins
+    int firstChanged = m_items.size();
+    int lastChanged = -1;
+    for (const QSharedPointer<CalendarItem> &item : items) {
+        if (!item) continue;
+        const IdTable::Id key = keyFor(*item);
+        const int row = rowOf(key);
+        if (row >= 0) {
+            unindexItem(*m_items.at(row));
+            m_items[row] = item;
+            m_display[row] = DisplayRow();
+            indexItem(*item);
+            firstChanged = qMin(firstChanged, row);
+            lastChanged = qMax(lastChanged, row);
+            continue;
+        }
+        const auto it = appendedIndex.constFind(key);
+        if (it != appendedIndex.constEnd()) {
+            appended[it.value()] = item;
+            continue;
+        }
+        appendedIndex.insert(key, appended.size());
+        appended.append(item);
+    }
+
+    if (lastChanged >= 0 || !appended.isEmpty()) {
+        m_timeIndexStale = true;
+    }
+    if (lastChanged >= 0) {
+        emit dataChanged(index(firstChanged, 0), index(lastChanged, columnCount() - 1));
+    }
+    if (!appended.isEmpty()) {
+        const int first = m_items.size();
+        beginInsertRows(QModelIndex(), first, first + appended.size() - 1);
+        m_items.reserve(first + appended.size());
+        m_display.resize(first + appended.size());
+        m_rowById.reserve(first + appended.size());
+        for (const QSharedPointer<CalendarItem> &item : std::as_const(appended)) {
+            m_rowById.insert(keyFor(*item), m_items.size());
+            m_items.append(item);
+            indexItem(*item);
+        }
+        endInsertRows();
+    }
+    qDebug() << "Cal: Merged" << items.size() << "items into" << m_id << "-" << appended.size() << "new";
+}
+
+void Cal::removeItems(const QStringList &itemIds)
+{
+    QList<int> rows;
+    rows.reserve(itemIds.size());
+    for (const QString &itemId : itemIds) {
+        const int row = rowOf(itemId);
+        if (row >= 0) rows.append(row);
+    }
+    if (rows.isEmpty()) return;
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // One removal per contiguous run, bottom-up so the rows of runs not yet removed stay valid
+    int last = rows.size() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && rows.at(first - 1) == rows.at(first) - 1) --first;
+        const int firstRow = rows.at(first);
+        const int count = last - first + 1;
+        beginRemoveRows(QModelIndex(), firstRow, firstRow + count - 1);
+        for (int row = firstRow; row < firstRow + count; ++row) {
+            const IdTable::Id key = keyFor(*m_items.at(row));
+            unindexItem(*m_items.at(row));
+            m_rowById.remove(key);
+            m_occurrences.remove(key);
+        }
+        m_items.remove(firstRow, count);
+        m_display.remove(firstRow, count);
+        reindexFrom(firstRow);
+        m_timeIndexStale = true;
+        endRemoveRows();
+        last = first - 1;
+    }
+    qDebug() << "Cal: Removed" << rows.size() << "items from" << m_id;
+}
+
+IdTable::Id Cal::keyFor(const CalendarItem &item) const
+{
+    // Items built for this calendar already carry the right handle; others are keyed by their uid here
+    return item.calendarHandle() == m_handle ? item.handle() : IdTable::item(m_handle, item.id());
+}
+
+QList<QSharedPointer<CalendarItem>> Cal::itemsInRange(const QDateTime &from, const QDateTime &to,
+                                                      QList<qint64> *starts) const
+{
+    QList<QSharedPointer<CalendarItem>> items;
+    if (!from.isValid() || !to.isValid()) return items;
+    ensureTimeIndex();
+    const QList<TimeIndex::Span> hits = spansOverlapping(from.toMSecsSinceEpoch(), to.toMSecsSinceEpoch());
+    items.reserve(hits.size());
+    if (starts) {
+        starts->clear();
+        starts->reserve(hits.size());
+    }
+    for (const TimeIndex::Span &hit : hits) {
+        items.append(m_items.at(hit.value));
+        if (starts) starts->append(hit.start);
+    }
+    return items;
+}
+
+QList<OccurrenceCache::Occurrence> Cal::occurrencesInRange(const QDateTime &from, const QDateTime &to) const
+{
+    QList<OccurrenceCache::Occurrence> occurrences;
+    const QList<QSharedPointer<CalendarItem>> candidates = itemsInRange(from, to);
+    QSet<QString> expandedSeries;
+    for (const QSharedPointer<CalendarItem> &item : candidates) {
+        if (item->recurs() && !item->recurrenceId().isValid()) expandedSeries.insert(item->seriesUid());
+    }
+    for (const QSharedPointer<CalendarItem> &item : candidates) {
+        const QDateTime start = item->dtStart().isValid() ? item->dtStart() : item->dtEndOrDue();
+        if (item->recurrenceId().isValid()) {
+            if (expandedSeries.contains(item->seriesUid())) continue; // Reported by its series in place of the instance
+            occurrences.append({item, start, item->dtEndOrDue(), item->recurrenceId()});
+        } else if (item->recurs()) {
+            QList<QSharedPointer<CalendarItem>> overrides;
+            for (int row : m_overrideRows.value(item->seriesUid())) {
+                overrides.append(m_items.at(row));
+            }
+            occurrences += m_occurrences.occurrences(item, from, to, overrides);
+        } else {
+            occurrences.append({item, start, item->dtEndOrDue(), QDateTime()});
+        }
+    }
+    std::stable_sort(occurrences.begin(), occurrences.end(),
+                     [](const OccurrenceCache::Occurrence &a, const OccurrenceCache::Occurrence &b) { return a.start < b.start; });
+    return occurrences;
+}
+
+QList<QSharedPointer<CalendarItem>> Cal::search(const QString &query) const
+{
+    syncItemIndexes();
+    if (!m_textIndexBuilt) {
+        m_textIndexBuilt = true;
+        for (const QSharedPointer<CalendarItem> &item : m_items) {
+            indexText(*item);
+        }
+    }
+
+    QList<int> rows;
+    for (IdTable::Id handle : m_textIndex.search(query)) {
+        const int row = rowOf(handle);
+        if (row >= 0) rows.append(row);
+    }
+    std::sort(rows.begin(), rows.end());
+    QList<QSharedPointer<CalendarItem>> items;
+    items.reserve(rows.size());
+    for (int row : std::as_const(rows)) {
+        items.append(m_items.at(row));
+    }
+    return items;
+}
+
+const TodoTree &Cal::todoTree() const
+{
+    syncItemIndexes();
+    if (!m_todoTreeBuilt) {
+        m_todoTreeBuilt = true;
+        for (const QSharedPointer<CalendarItem> &item : m_items) {
+            indexTodo(*item);
+        }
+    }
+    return m_todoTree;
+}
+
+QSharedPointer<CalendarItem> Cal::findItem(IdTable::Id itemHandle) const
+{
+    const int row = rowOf(itemHandle);
+    return row >= 0 ? m_items.at(row) : QSharedPointer<CalendarItem>();
+}
+
+void Cal::syncItemIndexes() const
+{
+    // Lazy items loaded since they were indexed now have a description and location to add
+    const quint64 materializations = CalendarItem::materializations();
+    if (materializations != m_indexedMaterializations) {
+        m_indexedMaterializations = materializations;
+        const QSet<IdTable::Id> headerOnly = m_headerOnlyText;
+        for (IdTable::Id handle : headerOnly) {
+            const int row = rowOf(handle);
+            if (row >= 0 && m_items.at(row)->isMaterialized()) indexText(*m_items.at(row));
+        }
+    }
+
+    // Edits made through the item directly never pass through this model; pick them up here
+    const quint64 latest = CalendarItem::latestRevision();
+    if (latest == m_indexedRevision) return;
+    if (m_textIndexBuilt || m_todoTreeBuilt) {
+        for (const QSharedPointer<CalendarItem> &item : m_items) {
+            if (item->revision() > m_indexedRevision) indexItem(*item);
+        }
+    }
+    m_indexedRevision = latest;
+}
+
+void Cal::indexItem(const CalendarItem &item) const
+{
+    indexText(item);
+    indexTodo(item);
+}
+
+void Cal::unindexItem(const CalendarItem &item) const
+{
+    const IdTable::Id key = keyFor(item);
+    if (m_textIndexBuilt) m_textIndex.remove(key);
+    m_headerOnlyText.remove(key);
+    if (m_todoTreeBuilt) m_todoTree.remove(key);
+}
+
+void Cal::indexTodo(const CalendarItem &item) const
+{
+    if (!m_todoTreeBuilt || !dynamic_cast<const Todo*>(&item)) return;
+    const QString parentUid = item.relatedTo();
+    m_todoTree.insert(keyFor(item), parentUid.isEmpty() ? 0 : IdTable::item(m_handle, parentUid), item.percentComplete());
+}
+
+void Cal::indexText(const CalendarItem &item) const
+{
+    if (!m_textIndexBuilt) return; // Nobody has searched this calendar yet
+    QStringList texts{item.summary()};
+    texts += item.categories();
+    if (item.isMaterialized()) {
+        const QSharedPointer<const KCalendarCore::Incidence> incidence = item.incidence();
+        texts << incidence->description() << incidence->location();
+        m_headerOnlyText.remove(keyFor(item));
+    } else {
+        // Indexing must not load every lazy item; the rest is added once something loads it
+        m_headerOnlyText.insert(keyFor(item));
+    }
+    m_textIndex.insert(keyFor(item), texts);
+}
+
+CategoryIndex *Cal::categoryIndex() const
+{
+    return m_parent ? m_parent->categoryIndex() : &m_ownCategories;
+}
+
+const QBitArray &Cal::categoryBits(int row) const
+{
+    const CalendarItem *item = m_items.at(row).data();
+    DisplayRow &display = m_display[row];
+    if (display.categoryRevision != item->revision()) {
+        display.categoryRevision = item->revision();
+        display.categoryBits = categoryIndex()->bitsFor(item->categories());
+    }
+    return display.categoryBits;
+}
+
+QList<QSharedPointer<CalendarItem>> Cal::itemsMatching(const CategoryIndex::CompiledFilter &filter) const
+{
+    QList<QSharedPointer<CalendarItem>> items;
+    for (int row = 0; row < m_items.size(); ++row) {
+        if (filter.matches(categoryBits(row))) items.append(m_items.at(row));
+    }
+    return items;
+}
+
+bool Cal::spanOf(const CalendarItem &item, TimeIndex::Span *span)
+{
+    QDateTime start = item.dtStart();
+    QDateTime end = item.dtEndOrDue();
+    if (!start.isValid()) start = end; // Todo with only a due date
+    if (!start.isValid()) return false;
+    if (!end.isValid() || end < start) end = start;
+    if (item.recurs()) {
+        // Open-ended unless the loaded rule says when it stops; the occurrence cache does the exact work
+        const KCalendarCore::Recurrence *recurrence = item.isMaterialized() ? item.incidence()->recurrence() : nullptr;
+        const QDateTime last = recurrence && recurrence->duration() != -1 ? recurrence->endDateTime() : QDateTime();
+        span->start = start.toMSecsSinceEpoch();
+        span->end = last.isValid() ? last.addMSecs(start.msecsTo(end)).addDays(1).toMSecsSinceEpoch()
+                                   : std::numeric_limits<qint64>::max();
+        return true;
+    }
+    if (item.allDay()) {
+        // All-day ends are inclusive dates; cover the whole last day
+        start = start.date().startOfDay(start.timeZone());
+        end = end.date().addDays(1).startOfDay(end.timeZone());
+    }
+    span->start = start.toMSecsSinceEpoch();
+    span->end = qMax(end.toMSecsSinceEpoch(), span->start + 1); // Instants still occupy their millisecond
+    return true;
+}
+
+void Cal::ensureTimeIndex() const
+{
+    const quint64 latest = CalendarItem::latestRevision();
+    if (!m_timeIndexStale && latest == m_timeIndexRevision) return;
+    if (!m_timeIndexStale) {
+        // Revisions are global, so finding our edits is still a pass over the rows, but only the
+        // edited rows get new spans; the tree itself is rebuilt once enough of them pile up
+        for (int row = 0; row < m_items.size(); ++row) {
+            const CalendarItem &item = *m_items.at(row);
+            if (item.revision() <= m_timeIndexRevision) continue;
+            if (item.recurrenceId().isValid() || std::any_of(m_overrideRows.cbegin(), m_overrideRows.cend(),
+                                                             [row](const QList<int> &rows) { return rows.contains(row); })) {
+                m_timeIndexStale = true; // Override lists are only built with the tree
+                break;
+            }
+            TimeIndex::Span span;
+            span.value = spanOf(item, &span) ? row : -1;
+            m_editedSpans.insert(row, span);
+        }
+        if (m_editedSpans.size() > qMax(EditedSpanLimit, int(m_items.size() / 16))) m_timeIndexStale = true;
+    }
+    if (m_timeIndexStale) {
+        QList<TimeIndex::Span> spans;
+        spans.reserve(m_items.size());
+        m_overrideRows.clear();
+        for (int row = 0; row < m_items.size(); ++row) {
+            if (m_items.at(row)->recurrenceId().isValid()) {
+                m_overrideRows[m_items.at(row)->seriesUid()].append(row);
+            }
+            TimeIndex::Span span;
+            if (spanOf(*m_items.at(row), &span)) {
+                span.value = row;
+                spans.append(span);
+            }
         }
+        m_timeIndex.build(std::move(spans));
+        m_editedSpans.clear();
+        m_timeIndexStale = false;
     }
-    qDebug() << "Cal: Item" << item->id() << "not found for removal in" << m_id;
+    m_timeIndexRevision = latest;
+}
+
+QList<TimeIndex::Span> Cal::spansOverlapping(qint64 from, qint64 to) const
+{
+    QList<TimeIndex::Span> hits = m_timeIndex.overlapping(from, to);
+    if (m_editedSpans.isEmpty()) return hits;
+    // The tree still holds the old spans of edited rows; their current ones are checked one by one
+    hits.removeIf([this](const TimeIndex::Span &hit) { return m_editedSpans.contains(hit.value); });
+    for (const TimeIndex::Span &span : std::as_const(m_editedSpans)) {
+        if (span.value >= 0 && span.start < to && span.end > from) hits.append(span);
+    }
+    std::stable_sort(hits.begin(), hits.end(), [](const TimeIndex::Span &a, const TimeIndex::Span &b) { return a.start < b.start; });
+    return hits;
+}
+
+void Cal::reindexFrom(int row)
+{
+    for (int i = row; i < m_items.size(); ++i) {
+        m_rowById[keyFor(*m_items.at(i))] = i;
+    }
+}
+
+qsizetype Cal::memoryFootprint() const
+{
+    qsizetype bytes = m_items.capacity() * qsizetype(sizeof(QSharedPointer<CalendarItem>));
+    bytes += m_rowById.size() * qsizetype(sizeof(IdTable::Id) + sizeof(int)); // Index entries
+    bytes += m_display.capacity() * qsizetype(sizeof(DisplayRow));
+    bytes += m_timeIndex.memoryFootprint();
+    bytes += m_occurrences.memoryFootprint();
+    bytes += m_textIndex.memoryFootprint();
+    for (const DisplayRow &row : m_display) {
+        for (const QString &cell : row.cells) {
+            bytes += cell.capacity() * qsizetype(sizeof(QChar));
+        }
+    }
+    for (const QSharedPointer<CalendarItem> &item : m_items) {
+        bytes += item->memoryFootprint();
+    }
+    return bytes;
 }
 
 QModelIndex Cal::index(int row, int column, const QModelIndex &parent) const
@@ -91,17 +517,46 @@ int Cal::columnCount(const QModelIndex &parent) const
     return 4; // Type, Summary, Start, End/Due
 }
 
+void Cal::setDoubleBooked(int row, bool doubleBooked)
+{
+    CalendarItem *item = m_items.at(row).data();
+    if (item->isDoubleBooked() == doubleBooked) return;
+    item->setDoubleBooked(doubleBooked);
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1), {DoubleBookedRole, Qt::ToolTipRole});
+}
+
 QVariant Cal::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || role != Qt::DisplayRole) return QVariant();
-    CalendarItem *item = m_items[index.row()].data();
-    switch (index.column()) {
-    case 0: return item->type();
-    case 1: return item->data(Qt::DisplayRole); // Summary
-    case 2: return item->data(Qt::UserRole);    // Start
-    case 3: return item->data(Qt::UserRole + 1); // End or Due
-    default: return QVariant();
+    if (!index.isValid() || index.column() >= columnCount()) return QVariant();
+    if (role == DoubleBookedRole) return m_items.at(index.row())->isDoubleBooked();
+    if (role == Qt::ToolTipRole) {
+        return m_items.at(index.row())->isDoubleBooked() ? QVariant("Overlaps another event") : QVariant();
+    }
+    if (role != Qt::DisplayRole && role != SortRole) return QVariant();
+    const DisplayRow &row = displayRow(index.row());
+    return role == SortRole ? row.sortKeys[index.column()] : QVariant(row.cells[index.column()]);
+}
+
+const Cal::DisplayRow &Cal::displayRow(int row) const
+{
+    // Painting and scrolling hit this per cell; formatting happens once per row and revision
+    const CalendarItem *item = m_items.at(row).data();
+    DisplayRow &display = m_display[row];
+    if (display.revision == item->revision()) {
+        return display;
     }
+    display.revision = item->revision();
+    display.cells[0] = item->type();
+    display.cells[1] = item->data(Qt::DisplayRole).toString();     // Summary
+    display.cells[2] = item->data(Qt::UserRole).toString();        // Start
+    display.cells[3] = item->data(Qt::UserRole + 1).toString();    // End or Due
+    const QDateTime start = item->dtStart();
+    const QDateTime end = item->dtEndOrDue();
+    display.sortKeys[0] = display.cells[0];
+    display.sortKeys[1] = display.cells[1].toCaseFolded();
+    display.sortKeys[2] = start.isValid() ? start.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+    display.sortKeys[3] = end.isValid() ? end.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+    return display;
 }
 
 QVariant Cal::headerData(int section, Qt::Orientation orientation, int role) const
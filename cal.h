@@ -4,7 +4,14 @@
 #include <QObject>
 #include <QAbstractTableModel>
 #include "calendaritem.h"
+#include "timeindex.h"
+#include "occurrencecache.h"
+#include "textindex.h"
+#include "categoryindex.h"
+#include "todotree.h"
 #include <QSharedPointer>
+#include <QHash>
+#include <QSet>
 
 class Collection;
 
@@ -15,6 +22,11 @@ class Cal : public QAbstractTableModel
     Q_PROPERTY(QString name READ name CONSTANT)
 
 public:
+    enum Role {
+        SortRole = Qt::UserRole, // Typed key per column: dates as epoch msecs, text case-folded
+        DoubleBookedRole         // bool, CalendarItem::isDoubleBooked(); the tooltip says so too
+    };
+
     explicit Cal(const QString &id, const QString &name, Collection *parent = nullptr);
     ~Cal() override = default;
 
@@ -23,10 +35,47 @@ public:
     void setName(const QString &name); // New method
     QString calId() const { return m_calId; } // Add if not present
     Collection* parentCollection() const { return m_parent; } // New getter
-    void addItem(QSharedPointer<CalendarItem> item);
+    void addItem(QSharedPointer<CalendarItem> item); // Replaces an item with the same id instead of duplicating it
     QList<QSharedPointer<CalendarItem>> items() const { return m_items; }
+    QSharedPointer<CalendarItem> findItem(const QString &itemId) const;
+    QSharedPointer<CalendarItem> findItem(IdTable::Id itemHandle) const;
+    int rowOf(const QString &itemId) const { return m_rowById.value(IdTable::findItem(m_handle, itemId), -1); }
+    int rowOf(IdTable::Id itemHandle) const { return m_rowById.value(itemHandle, -1); }
+    IdTable::Id handle() const { return m_handle; }
+    QSharedPointer<CalendarItem> itemAt(int row) const { return m_items.value(row); } // Null outside the table
+    IdTable::Id handleAt(int row) const { return keyFor(*m_items.at(row)); } // The handle rowOf() knows the row by
     void updateItem(const QSharedPointer<CalendarItem> &item);
     void removeItem(const QSharedPointer<CalendarItem> &item);
+    // Batch variants: one dataChanged for replaced rows and one row insertion or removal per call,
+    // so attached views relayout once per batch rather than once per item
+    void addItems(const QList<QSharedPointer<CalendarItem>> &items);
+    void updateItems(const QList<QSharedPointer<CalendarItem>> &items);
+    void removeItems(const QStringList &itemIds);
+    qsizetype memoryFootprint() const; // Sum of CalendarItem::memoryFootprint() over all items
+    void setDoubleBooked(int row, bool doubleBooked); // Notifies views with DoubleBookedRole if the flag changes
+
+    // Items overlapping [from, to), ordered by start; starts receives each hit's start in msecs.
+    // Served from a time index that is rebuilt on the first query after the items changed.
+    // A recurring item is listed once if any of its instances may fall in the window.
+    QList<QSharedPointer<CalendarItem>> itemsInRange(const QDateTime &from, const QDateTime &to,
+                                                     QList<qint64> *starts = nullptr) const;
+    // Every instance overlapping [from, to), ordered by start: single items once, series expanded through
+    // a per-item cache with EXDATEs and RECURRENCE-ID overrides applied
+    QList<OccurrenceCache::Occurrence> occurrencesInRange(const QDateTime &from, const QDateTime &to) const;
+
+    // Items whose summary, description, location or categories contain a word starting with every
+    // term of the query, in row order. The word index is built on the first search and kept current
+    // from then on; lazy items contribute their summary and categories until they are loaded.
+    QList<QSharedPointer<CalendarItem>> search(const QString &query) const;
+
+    // Categories of a row as bits of the collection's CategoryIndex; recomputed only after the item changes
+    const QBitArray &categoryBits(int row) const;
+    CategoryIndex *categoryIndex() const; // The parent collection's dictionary, or this calendar's own
+    QList<QSharedPointer<CalendarItem>> itemsMatching(const CategoryIndex::CompiledFilter &filter) const;
+
+    // To-dos arranged by RELATED-TO, keyed by item handle (see findItem(IdTable::Id)). Built on first use
+    // and updated per item afterwards, like the search index.
+    const TodoTree &todoTree() const;
 
     // QAbstractTableModel
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
@@ -37,11 +86,53 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
 private:
+    void replaceRow(int row, const QSharedPointer<CalendarItem> &item);
+    void appendRow(const QSharedPointer<CalendarItem> &item);
+    void mergeItems(const QList<QSharedPointer<CalendarItem>> &items);
+    void reindexFrom(int row);
+    IdTable::Id keyFor(const CalendarItem &item) const;
+    static bool spanOf(const CalendarItem &item, TimeIndex::Span *span);
+    void ensureTimeIndex() const;
+    QList<TimeIndex::Span> spansOverlapping(qint64 from, qint64 to) const;
+    // Keep the search index and to-do tree, once built, in step with the items
+    void syncItemIndexes() const;
+    void indexItem(const CalendarItem &item) const;
+    void unindexItem(const CalendarItem &item) const;
+    void indexText(const CalendarItem &item) const;
+    void indexTodo(const CalendarItem &item) const;
+
+    // Formatted cells and sort keys for one row, rebuilt when the item's revision moves on
+    struct DisplayRow {
+        quint64 revision = 0; // 0: not filled yet
+        QString cells[4];
+        QVariant sortKeys[4];
+        quint64 categoryRevision = 0; // Category bits are filled separately; filtering needs no cells
+        QBitArray categoryBits;
+    };
+    const DisplayRow &displayRow(int row) const;
+
     QString m_id;
     QString m_name;
     QString m_calId; // Set in constructor
     QList<QSharedPointer<CalendarItem>> m_items;
+    QHash<IdTable::Id, int> m_rowById; // Interned item id -> row in m_items; ids are unique within a calendar
+    mutable QList<DisplayRow> m_display; // Parallel to m_items, filled as rows are painted
+    mutable TimeIndex m_timeIndex; // Values are rows
+    mutable bool m_timeIndexStale = true; // Rows were added, replaced or removed since the build
+    mutable quint64 m_timeIndexRevision = 0; // CalendarItem::latestRevision() when edits were last picked up
+    mutable QHash<int, TimeIndex::Span> m_editedSpans; // Rows edited in place since the build; value -1: no span
+    mutable QHash<QString, QList<int>> m_overrideRows; // Series UID -> rows of its overrides, built with the time index
+    mutable OccurrenceCache m_occurrences;
+    mutable TextIndex m_textIndex; // Keyed by item handle; empty until the first search
+    mutable bool m_textIndexBuilt = false;
+    mutable TodoTree m_todoTree;
+    mutable bool m_todoTreeBuilt = false;
+    mutable quint64 m_indexedRevision = 0; // CalendarItem::latestRevision() the item indexes have caught up with
+    mutable QSet<IdTable::Id> m_headerOnlyText; // Indexed without description and location, not loaded yet
+    mutable quint64 m_indexedMaterializations = 0; // CalendarItem::materializations() at the last check
+    mutable CategoryIndex m_ownCategories; // Used only without a parent collection
     Collection* m_parent; // New member to store parent explicitly
+    IdTable::Id m_handle; // After m_parent: registered under the parent collection
 };
 
 #endif // CAL_H
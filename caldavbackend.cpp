@@ -104,6 +104,7 @@ void CalDAVBackend::onCollectionsLoaded(KJob *job)
             meta.id = collectionId + "_" + simplifiedName;
             meta.name = col.displayName().isEmpty() ? col.url().toDisplayString() : col.displayName();
             m_idToUrl[meta.id] = col.url().toDisplayString();
+            IdTable::calendar(collectionId, meta.id);
             qDebug() << "CalDAVBackend: Discovered calendar" << meta.id << meta.name;
             emit calendarDiscovered(collectionId, meta);
 
@@ -126,7 +127,7 @@ void CalDAVBackend::processNextItemLoad()
         qDebug() << "CalDAVBackend: Item load queue empty";
         if (m_activeJobs.isEmpty()) {
             qDebug() << "CalDAVBackend: All jobs completed, emitting syncCompleted";
-            emit syncCompleted(m_calMap.firstKey().split("_").first()); // Extract collectionId
+            emit syncCompleted(IdTable::collectionIdOf(m_calMap.firstKey()));
             qDeleteAll(m_calMap); // Clean up here after sync is fully done
             m_calMap.clear();
         } else {
@@ -198,6 +199,8 @@ void CalDAVBackend::processNextItemLoad()
                 qDebug() << "CalDAVBackend: MULTIGET fetched" << fetchedItems.size() << "items for" << calId;
 
                 KCalendarCore::ICalFormat format;
+                QList<QSharedPointer<CalendarItem>> batch;
+                batch.reserve(fetchedItems.size());
                 for (const KDAV::DavItem &item : fetchedItems) {
                     QByteArray rawData = item.data();
                     if (rawData.isEmpty()) {
@@ -213,17 +216,18 @@ void CalDAVBackend::processNextItemLoad()
                     QString itemUid = incidence->uid().isEmpty() ? QString::number(qHash(item.url().toDisplayString())) : incidence->uid();
                     QSharedPointer<CalendarItem> calItem;
                     if (incidence->type() == KCalendarCore::IncidenceBase::TypeEvent) {
-                        calItem = QSharedPointer<CalendarItem>(new Event(calId, itemUid, nullptr));
+                        calItem = QSharedPointer<Event>::create(calId, itemUid);
                     } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeTodo) {
-                        calItem = QSharedPointer<CalendarItem>(new Todo(calId, itemUid, nullptr));
+                        calItem = QSharedPointer<Todo>::create(calId, itemUid);
                     }
                     if (calItem) {
                         calItem->setIncidence(incidence);
-                        QString verId = fetchItemVersionIdentifier(calId, calItem->id());
-                        emit itemLoaded(cal, calItem, verId);
+                        calItem->setVersionIdentifier(fetchItemVersionIdentifier(calId, calItem->id()));
+                        batch.append(calItem);
                     }
 
                 }
+                emit itemsLoaded(cal, batch); // One model insertion for the whole MULTIGET
                 emit calendarLoaded(cal);
             }
             m_activeJobs.removeOne(fetchJob); // Remove after completion
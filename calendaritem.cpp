@@ -2,128 +2,335 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QString>
+#include <atomic>
 
-CalendarItem::CalendarItem(const QString &calId, const QString &itemId, QObject *parent)
-    : QObject(parent), m_calId(calId), m_itemId(itemId), m_lastModified(QDateTime::currentDateTime())
+namespace {
+std::atomic<quint64> revisionCounter{0};
+quint64 nextRevision() { return ++revisionCounter; }
+std::atomic<quint64> materializationCounter{0};
+}
+
+CalendarItem::CalendarItem(const QString &calId, const QString &itemId)
+    : m_revision(nextRevision()), m_itemId(itemId), m_lastModified(QDateTime::currentDateTime()),
+      m_calHandle(IdTable::calendar(calId)), m_handle(IdTable::item(m_calHandle, itemId))
+{
+}
+
+quint64 CalendarItem::latestRevision()
+{
+    return revisionCounter.load();
+}
+
+quint64 CalendarItem::materializations()
 {
+    return materializationCounter.load();
+}
+
+void CalendarItem::setDirty(bool dirty)
+{
+    m_dirty = dirty;
+    if (dirty) {
+        m_revision = nextRevision();
+    }
+}
+
+QSharedPointer<const KCalendarCore::Incidence> CalendarItem::incidence() const
+{
+    materialize();
+    return m_incidence.get();
+}
+
+KCalendarCore::Incidence::Ptr CalendarItem::mutableIncidence()
+{
+    if (!materialize()) return KCalendarCore::Incidence::Ptr();
+    m_incidence.write();
+    setDirty(true); // The caller edits right after, so the new revision is taken now, as the setters do
+    return m_incidence.get();
 }
 
 void CalendarItem::setIncidence(const KCalendarCore::Incidence::Ptr &incidence)
 {
-    m_incidence = incidence;
+    m_incidence = CowIncidence(incidence);
+    m_lazy.reset();
+    m_revision = nextRevision();
     if (incidence) {
         m_lastModified = QDateTime::currentDateTime();
     }
 }
 
-// --- Event ---
-Event::Event(const QString &calId, const QString &itemId, QObject *parent)
-    : CalendarItem(calId, itemId, parent)
+CalendarItem::Header CalendarItem::headerFor(const KCalendarCore::Incidence::Ptr &incidence)
 {
+    Header header;
+    if (!incidence) return header;
+    header.summary = incidence->summary();
+    header.allDay = incidence->allDay();
+    header.categories = incidence->categories();
+    header.recurs = incidence->recurs();
+    header.relatedTo = incidence->relatedTo(KCalendarCore::Incidence::RelTypeParent);
+    if (incidence->hasRecurrenceId()) {
+        header.recurrenceId = incidence->recurrenceId();
+        header.seriesUid = incidence->uid();
+    }
+    if (incidence->type() == KCalendarCore::IncidenceBase::TypeEvent) {
+        KCalendarCore::Event::Ptr event = incidence.staticCast<KCalendarCore::Event>();
+        header.dtStart = event->dtStart();
+        header.dtEndOrDue = event->dtEnd();
+        header.transparent = event->transparency() == KCalendarCore::Event::Transparent;
+    } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeTodo) {
+        KCalendarCore::Todo::Ptr todo = incidence.staticCast<KCalendarCore::Todo>();
+        header.dtStart = todo->hasStartDate() ? todo->dtStart() : QDateTime();
+        header.dtEndOrDue = todo->hasDueDate() ? todo->dtDue() : QDateTime();
+        header.percentComplete = todo->isCompleted() ? 100 : todo->percentComplete();
+    }
+    return header;
 }
 
-QString Event::type() const { return "Event"; }
+void CalendarItem::setLazyIncidence(const Header &header, const IncidenceLoader &loader)
+{
+    m_incidence.reset();
+    m_lazy.reset(new LazyState{header, loader});
+    m_revision = nextRevision();
+}
 
-QVariant Event::data(int role) const
+bool CalendarItem::materialize() const
 {
-    if (!m_incidence) return QVariant();
-    if (role == Qt::DisplayRole) return m_incidence->summary();
-    if (role == Qt::UserRole) return m_incidence.staticCast<KCalendarCore::Event>()->dtStart().toString();
-    if (role == Qt::UserRole + 1) return m_incidence.staticCast<KCalendarCore::Event>()->dtEnd().toString();
-    return QVariant();
+    if (m_incidence) return true;
+    if (!m_lazy) return false;
+    m_incidence = CowIncidence(m_lazy->loader());
+    if (!m_incidence) {
+        qWarning() << "CalendarItem: Failed to load incidence for" << m_itemId;
+        return false;
+    }
+    m_lazy.reset(); // The incidence now answers everything the header did
+    ++materializationCounter; // Same content, so no new revision; indexes of what only the incidence has look here
+    return true;
 }
 
-QString Event::toICal() const
+const CalendarItem::Header &CalendarItem::lazyHeader() const
 {
-    if (!m_incidence) return QString();
+    static const Header empty;
+    return m_lazy ? m_lazy->header : empty;
+}
+
+bool CalendarItem::recurs() const
+{
+    return m_incidence ? m_incidence->recurs() : lazyHeader().recurs;
+}
+
+QDateTime CalendarItem::recurrenceId() const
+{
+    if (!m_incidence) return lazyHeader().recurrenceId;
+    return m_incidence->hasRecurrenceId() ? m_incidence->recurrenceId() : QDateTime();
+}
+
+QString CalendarItem::seriesUid() const
+{
+    if (m_incidence) return m_incidence->uid();
+    return lazyHeader().seriesUid.isEmpty() ? m_itemId : lazyHeader().seriesUid;
+}
+
+QString CalendarItem::relatedTo() const
+{
+    return m_incidence ? m_incidence->relatedTo(KCalendarCore::Incidence::RelTypeParent) : lazyHeader().relatedTo;
+}
+
+int CalendarItem::percentComplete() const
+{
+    if (!m_incidence) return lazyHeader().percentComplete;
+    if (m_incidence->type() != KCalendarCore::IncidenceBase::TypeTodo) return 0;
+    const KCalendarCore::Todo *todo = m_incidence.as<KCalendarCore::Todo>();
+    return todo->isCompleted() ? 100 : todo->percentComplete();
+}
+
+bool CalendarItem::isTransparent() const
+{
+    if (!m_incidence) return lazyHeader().transparent;
+    if (m_incidence->type() != KCalendarCore::IncidenceBase::TypeEvent) return false;
+    return m_incidence.as<KCalendarCore::Event>()->transparency() == KCalendarCore::Event::Transparent;
+}
+
+QString CalendarItem::summary() const
+{
+    return m_incidence ? m_incidence->summary() : (m_lazy ? m_lazy->header.summary : QString());
+}
+
+void CalendarItem::setSummary(const QString &summary)
+{
+    if (materialize()) {
+        m_incidence.write()->setSummary(summary);
+        setDirty(true);
+    }
+}
+
+QByteArray CalendarItem::icalData() const
+{
+    if (m_serialized && m_serialized->revision == m_revision) {
+        return m_serialized->data;
+    }
+    if (!materialize()) return QByteArray();
+    if (!m_serialized) {
+        m_serialized.reset(new Serialized);
+    }
+    m_serialized->revision = m_revision;
+    m_serialized->data = serialize(m_incidence.get());
+    return m_serialized->data;
+}
+
+QByteArray CalendarItem::serialize(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    if (!incidence) return QByteArray();
     KCalendarCore::ICalFormat format;
     KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
-    tempCalendar->addIncidence(m_incidence);
-    return format.toString(tempCalendar);
+    tempCalendar->addIncidence(incidence);
+    return format.toString(tempCalendar).toUtf8();
+}
+
+qsizetype CalendarItem::memoryFootprint() const
+{
+    // Rough figure: string payloads are exact, KCalendarCore's private data is a fixed estimate
+    constexpr qsizetype IncidencePrivateCost = 1024; // d-pointer, attendee/alarm/attachment lists, recurrence
+    auto text = [](const QString &s) { return s.capacity() * qsizetype(sizeof(QChar)); };
+    auto list = [&text](const QStringList &l) {
+        qsizetype bytes = l.capacity() * qsizetype(sizeof(QString));
+        for (const QString &s : l) bytes += text(s);
+        return bytes;
+    };
+
+    qsizetype bytes = sizeof(*this) + text(m_itemId) + text(m_etag); // Calendar id lives once in IdTable
+    if (m_lazy) {
+        bytes += sizeof(LazyState) + text(m_lazy->header.summary) + list(m_lazy->header.categories);
+        bytes += 64; // Captured path and hash
+    }
+    if (m_incidence) {
+        bytes += IncidencePrivateCost + text(m_incidence->uid()) + text(m_incidence->summary())
+                 + text(m_incidence->description()) + text(m_incidence->location())
+                 + list(m_incidence->categories());
+    }
+    if (m_serialized) {
+        bytes += sizeof(Serialized) + m_serialized->data.capacity();
+    }
+    return bytes;
 }
 
-CalendarItem* Event::clone(QObject *parent) const
+void CalendarItem::copyIncidenceTo(CalendarItem *clone) const
 {
-    if (!m_incidence) return nullptr;
-    Event *clone = new Event(m_calId, m_itemId.split("_").last(), parent);
-    clone->setIncidence(KCalendarCore::Incidence::Ptr(m_incidence->clone()));
+    if (m_incidence) {
+        // Shared until either side is edited; the first write clones it
+        clone->m_incidence = m_incidence;
+        clone->m_lazy.reset();
+    } else if (m_lazy) {
+        clone->setLazyIncidence(m_lazy->header, m_lazy->loader); // Both copies load on demand
+    }
+}
+
+void CalendarItem::copyStateTo(CalendarItem *clone) const
+{
+    copyIncidenceTo(clone);
     clone->setLastModified(m_lastModified);
-    // Replace setEtag with setVersionIdentifier
     clone->setVersionIdentifier(m_etag);
     clone->setDirty(m_dirty);
     clone->setConflictStatus(m_conflictStatus);
+    clone->setDoubleBooked(m_doubleBooked);
+    clone->m_revision = m_revision; // Same content, so the same revision
+    if (m_serialized && m_serialized->revision == m_revision) {
+        clone->m_serialized.reset(new Serialized(*m_serialized)); // Bytes are implicitly shared
+    }
+}
+
+// --- Event ---
+Event::Event(const QString &calId, const QString &itemId)
+    : CalendarItem(calId, itemId)
+{
+}
+
+QString Event::type() const { return "Event"; }
+
+QVariant Event::data(int role) const
+{
+    if (!hasContent()) return QVariant();
+    if (role == Qt::DisplayRole) return summary();
+    if (role == Qt::UserRole) return dtStart().toString();
+    if (role == Qt::UserRole + 1) return dtEndOrDue().toString();
+    return QVariant();
+}
+
+CalendarItem* Event::clone() const
+{
+    if (!hasContent()) return nullptr;
+    Event *clone = new Event(calId(), m_itemId);
+    copyStateTo(clone);
     return clone;
 }
 
 
 QDateTime Event::dtStart() const
 {
-    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->dtStart() : QDateTime();
+    return m_incidence ? m_incidence.as<KCalendarCore::Event>()->dtStart() : lazyHeader().dtStart;
 }
 
 void Event::setDtStart(const QDateTime &dtStart)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Event>()->setDtStart(dtStart);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Event>()->setDtStart(dtStart);
         setDirty(true);
     }
 }
 
 QDateTime Event::dtEndOrDue() const
 {
-    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->dtEnd() : QDateTime();
+    return m_incidence ? m_incidence.as<KCalendarCore::Event>()->dtEnd() : lazyHeader().dtEndOrDue;
 }
 
 void Event::setDtEndOrDue(const QDateTime &dtEndOrDue)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Event>()->setDtEnd(dtEndOrDue);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Event>()->setDtEnd(dtEndOrDue);
         setDirty(true);
     }
 }
 
 QStringList Event::categories() const
 {
-    return m_incidence ? m_incidence->categories() : QStringList();
+    return m_incidence ? m_incidence->categories() : lazyHeader().categories;
 }
 
 void Event::setCategories(const QStringList &categories)
 {
-    if (m_incidence) {
-        m_incidence->setCategories(categories);
+    if (materialize()) {
+        m_incidence.write()->setCategories(categories);
         setDirty(true);
     }
 }
 
 QString Event::description() const
 {
-    return m_incidence ? m_incidence->description() : QString();
+    return materialize() ? m_incidence->description() : QString();
 }
 
 void Event::setDescription(const QString &description)
 {
-    if (m_incidence) {
-        m_incidence->setDescription(description);
+    if (materialize()) {
+        m_incidence.write()->setDescription(description);
         setDirty(true);
     }
 }
 
 bool Event::allDay() const
 {
-    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->allDay() : false;
+    return m_incidence ? m_incidence.as<KCalendarCore::Event>()->allDay() : lazyHeader().allDay;
 }
 
 void Event::setAllDay(bool allDay)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Event>()->setAllDay(allDay);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Event>()->setAllDay(allDay);
         setDirty(true);
     }
 }
 
 // --- Todo ---
-Todo::Todo(const QString &calId, const QString &itemUid, QObject *parent)
-    : CalendarItem(calId, itemUid, parent)
+Todo::Todo(const QString &calId, const QString &itemUid)
+    : CalendarItem(calId, itemUid)
 {
 }
 
@@ -131,99 +338,89 @@ QString Todo::type() const { return "Todo"; }
 
 QVariant Todo::data(int role) const
 {
-    if (!m_incidence) return QVariant();
-    if (role == Qt::DisplayRole) return m_incidence->summary();
-    if (role == Qt::UserRole) return m_incidence.staticCast<KCalendarCore::Todo>()->dtStart().toString();
-    if (role == Qt::UserRole + 1) return m_incidence.staticCast<KCalendarCore::Todo>()->dtDue().toString();
+    if (!hasContent()) return QVariant();
+    if (role == Qt::DisplayRole) return summary();
+    if (role == Qt::UserRole) return m_incidence ? m_incidence.as<KCalendarCore::Todo>()->dtStart().toString()
+                                                 : lazyHeader().dtStart.toString();
+    if (role == Qt::UserRole + 1) return m_incidence ? m_incidence.as<KCalendarCore::Todo>()->dtDue().toString()
+                                                     : lazyHeader().dtEndOrDue.toString();
     return QVariant();
 }
 
-QString Todo::toICal() const
-{
-    if (!m_incidence) return QString();
-    KCalendarCore::ICalFormat format;
-    KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
-    tempCalendar->addIncidence(m_incidence);
-    return format.toString(tempCalendar);
-}
-
-CalendarItem* Todo::clone(QObject *parent) const
+CalendarItem* Todo::clone() const
 {
-    if (!m_incidence) return nullptr;
-    Todo *clone = new Todo(m_calId, m_itemId.split("_").last(), parent);
-    clone->setIncidence(KCalendarCore::Incidence::Ptr(m_incidence->clone()));
-    clone->setLastModified(m_lastModified);
-    // Replace setEtag with setVersionIdentifier
-    clone->setVersionIdentifier(m_etag);
-    clone->setDirty(m_dirty);
-    clone->setConflictStatus(m_conflictStatus);
+    if (!hasContent()) return nullptr;
+    Todo *clone = new Todo(calId(), m_itemId);
+    copyStateTo(clone);
     return clone;
 }
 
 
 QDateTime Todo::dtStart() const
 {
-    return m_incidence && m_incidence.staticCast<KCalendarCore::Todo>()->hasStartDate() ?
-               m_incidence.staticCast<KCalendarCore::Todo>()->dtStart() : QDateTime();
+    if (!m_incidence) return lazyHeader().dtStart;
+    return m_incidence.as<KCalendarCore::Todo>()->hasStartDate() ?
+               m_incidence.as<KCalendarCore::Todo>()->dtStart() : QDateTime();
 }
 
 void Todo::setDtStart(const QDateTime &dtStart)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Todo>()->setDtStart(dtStart);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Todo>()->setDtStart(dtStart);
         setDirty(true);
     }
 }
 
 QDateTime Todo::dtEndOrDue() const
 {
-    return m_incidence && m_incidence.staticCast<KCalendarCore::Todo>()->hasDueDate() ?
-               m_incidence.staticCast<KCalendarCore::Todo>()->dtDue() : QDateTime();
+    if (!m_incidence) return lazyHeader().dtEndOrDue;
+    return m_incidence.as<KCalendarCore::Todo>()->hasDueDate() ?
+               m_incidence.as<KCalendarCore::Todo>()->dtDue() : QDateTime();
 }
 
 void Todo::setDtEndOrDue(const QDateTime &dtEndOrDue)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Todo>()->setDtDue(dtEndOrDue);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Todo>()->setDtDue(dtEndOrDue);
         setDirty(true);
     }
 }
 
 QStringList Todo::categories() const
 {
-    return m_incidence ? m_incidence->categories() : QStringList();
+    return m_incidence ? m_incidence->categories() : lazyHeader().categories;
 }
 
 void Todo::setCategories(const QStringList &categories)
 {
-    if (m_incidence) {
-        m_incidence->setCategories(categories);
+    if (materialize()) {
+        m_incidence.write()->setCategories(categories);
         setDirty(true);
     }
 }
 
 QString Todo::description() const
 {
-    return m_incidence ? m_incidence->description() : QString();
+    return materialize() ? m_incidence->description() : QString();
 }
 
 void Todo::setDescription(const QString &description)
 {
-    if (m_incidence) {
-        m_incidence->setDescription(description);
+    if (materialize()) {
+        m_incidence.write()->setDescription(description);
         setDirty(true);
     }
 }
 
 bool Todo::allDay() const
 {
-    return m_incidence ? m_incidence.staticCast<KCalendarCore::Todo>()->allDay() : false;
+    return m_incidence ? m_incidence.as<KCalendarCore::Todo>()->allDay() : lazyHeader().allDay;
 }
 
 void Todo::setAllDay(bool allDay)
 {
-    if (m_incidence) {
-        m_incidence.staticCast<KCalendarCore::Todo>()->setAllDay(allDay);
+    if (materialize()) {
+        m_incidence.write<KCalendarCore::Todo>()->setAllDay(allDay);
         setDirty(true);
     }
 }
@@ -1,40 +1,103 @@
 #ifndef CALENDARITEM_H
 #define CALENDARITEM_H
 
-#include <QObject>
 #include <QSharedPointer>
+#include <QVariant>
+#include "idtable.h"
+#include "cowincidence.h"
 #include <KCalendarCore/Incidence>
 #include <KCalendarCore/ICalFormat>
 #include <KCalendarCore/MemoryCalendar>
 #include <KCalendarCore/Event>  // Added for Event definition
 #include <KCalendarCore/Todo>   // Added for Todo definition
+#include <functional>
+#include <memory>
 
-class CalendarItem : public QObject
+// Plain value-like record held through QSharedPointer; deliberately not a QObject, since a collection
+// holds one per entry and QObject's private data, allocation and thread affinity dominated its size.
+// Create with QSharedPointer<Event>::create() so the record and its reference count share one allocation.
+class CalendarItem
 {
-    Q_OBJECT
-    Q_PROPERTY(QString id READ id CONSTANT)
-    Q_PROPERTY(KCalendarCore::Incidence::Ptr incidence READ incidence WRITE setIncidence)
-
 public:
-    explicit CalendarItem(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    CalendarItem(const QString &calId, const QString &itemUid);
     virtual ~CalendarItem() = default;
+    CalendarItem(const CalendarItem &) = delete;
+    CalendarItem &operator=(const CalendarItem &) = delete;
 
     virtual QString id() const { return m_itemId; }
-    virtual QString toICal() const = 0;
-    virtual CalendarItem* clone(QObject *parent = nullptr) const = 0; // Single declaration with default parameter
-
-    QString calId() const { return m_calId; }
+    virtual CalendarItem* clone() const = 0;
+
+    // The item as a one-incidence VCALENDAR in UTF-8; what the session journal and every backend store.
+    // Serialized once per revision and reused until the item changes; clones share the bytes.
+    QByteArray icalData() const;
+    QString toICal() const { return QString::fromUtf8(icalData()); }
+    static QByteArray serialize(const KCalendarCore::Incidence::Ptr &incidence);
+
+    QString calId() const { return IdTable::text(m_calHandle); }
+    // Interned handles; compare and hash these instead of the id strings
+    IdTable::Id handle() const { return m_handle; }
+    IdTable::Id calendarHandle() const { return m_calHandle; }
     QDateTime lastModified() const { return m_lastModified; }
     void setLastModified(const QDateTime &lastModified) { m_lastModified = lastModified; }
     QString versionIdentifier() const { return m_etag; }
     void setVersionIdentifier(const QString &id) { m_etag = id; }
 
     bool isDirty() const { return m_dirty; }
-    void setDirty(bool dirty) { m_dirty = dirty; }
-
-    KCalendarCore::Incidence::Ptr incidence() const { return m_incidence; }
+    void setDirty(bool dirty);
+
+    // Changes whenever the content may have changed; equal revisions mean equal content, also across clones.
+    quint64 revision() const { return m_revision; }
+    // Highest revision handed out so far; unchanged means no item anywhere has changed
+    static quint64 latestRevision();
+    // Lazy items loaded so far; unchanged means no item has gained its incidence since
+    static quint64 materializations();
+
+    // Loads the incidence first if the item was created lazily. Clones share it, so it is read-only.
+    QSharedPointer<const KCalendarCore::Incidence> incidence() const;
+    // Same, but first gives this item its own copy if a clone still shares it. Marks the item dirty with a
+    // new revision, so edit through the pointer right away rather than keeping it for later.
+    KCalendarCore::Incidence::Ptr mutableIncidence();
     void setIncidence(const KCalendarCore::Incidence::Ptr &incidence);
 
+    // What the table view shows; enough to list an item without its incidence
+    struct Header {
+        QString summary;
+        QDateTime dtStart;
+        QDateTime dtEndOrDue;
+        bool allDay = false;
+        bool recurs = false;
+        QStringList categories;
+        QDateTime recurrenceId; // Set on overrides of a single instance
+        QString seriesUid;      // UID of the series an override belongs to
+        QString relatedTo;      // Parent UID from RELATED-TO
+        int percentComplete = 0; // To-dos; 100 once completed
+        bool transparent = false; // Events marked TRANSP:TRANSPARENT
+    };
+    using IncidenceLoader = std::function<KCalendarCore::Incidence::Ptr()>;
+    static Header headerFor(const KCalendarCore::Incidence::Ptr &incidence);
+
+    // Keep only the header; the loader runs on first access to the full incidence
+    void setLazyIncidence(const Header &header, const IncidenceLoader &loader);
+    bool isMaterialized() const { return !m_incidence.isNull(); }
+    bool hasContent() const { return m_incidence || m_lazy; }
+    bool materialize() const;
+
+    QString summary() const;
+    void setSummary(const QString &summary);
+
+    // Recurrence shape, answered from the header for lazy items
+    bool recurs() const;
+    QDateTime recurrenceId() const; // Instance an override replaces; invalid for everything else
+    QString seriesUid() const;      // UID shared by a series and its overrides
+
+    // To-do hierarchy and progress, also answered from the header
+    QString relatedTo() const;  // Parent UID, empty for top-level items
+    int percentComplete() const; // 0-100; always 0 for events
+    bool isTransparent() const;  // Event that does not block time (TRANSP:TRANSPARENT); false for to-dos
+
+    // Approximate heap bytes held by this item, including its incidence once loaded
+    qsizetype memoryFootprint() const;
+
     virtual QString type() const = 0;
     virtual QVariant data(int role) const = 0;
 
@@ -51,7 +114,7 @@ public:
     virtual void setAllDay(bool allDay) = 0;
 
     // Define an enum to track conflict status.
-    enum class ConflictStatus {
+    enum class ConflictStatus : quint8 {
         None,
         Pending,
         Resolved
@@ -61,28 +124,49 @@ public:
     ConflictStatus conflictStatus() const { return m_conflictStatus; }
     void setConflictStatus(ConflictStatus status) { m_conflictStatus = status; }
 
+    // Overlaps another opaque event of the collection; maintained by OverlapDetector, not part of the content
+    bool isDoubleBooked() const { return m_doubleBooked; }
+    void setDoubleBooked(bool doubleBooked) { m_doubleBooked = doubleBooked; }
+
 protected:
-    ConflictStatus m_conflictStatus = ConflictStatus::None;
+    void copyIncidenceTo(CalendarItem *clone) const;
+    void copyStateTo(CalendarItem *clone) const;
+    const Header &lazyHeader() const; // Empty header when there is nothing to load
+
+    // Only lazily loaded items carry a header and loader; dropped once the incidence is loaded
+    struct LazyState {
+        Header header;
+        IncidenceLoader loader;
+    };
 
+    // Result of the last icalData() call; stale once the revision has moved on
+    struct Serialized {
+        quint64 revision = 0;
+        QByteArray data;
+    };
 
-protected:
-    QString m_calId;
+    // Ordered largest first so the record packs without padding holes
+    quint64 m_revision;
+    mutable CowIncidence m_incidence; // Null until materialized in lazy mode; shared with clones until written
+    mutable std::unique_ptr<LazyState> m_lazy;
+    mutable std::unique_ptr<Serialized> m_serialized; // Allocated on first serialization
     QString m_itemId;
-    KCalendarCore::Incidence::Ptr m_incidence;
-    QDateTime m_lastModified;
     QString m_etag;
+    QDateTime m_lastModified;
+    IdTable::Id m_calHandle;
+    IdTable::Id m_handle;
     bool m_dirty = false; // New member to track dirty state
+    ConflictStatus m_conflictStatus = ConflictStatus::None;
+    bool m_doubleBooked = false;
 };
 
 class Event : public CalendarItem
 {
-    Q_OBJECT
 public:
-    explicit Event(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    Event(const QString &calId, const QString &itemUid);
     QString type() const override;
     QVariant data(int role) const override;
-    QString toICal() const override;
-    CalendarItem* clone(QObject *parent = nullptr) const override;
+    CalendarItem* clone() const override;
 
     QDateTime dtStart() const override;
     void setDtStart(const QDateTime &dtStart) override;
@@ -98,13 +182,11 @@ public:
 
 class Todo : public CalendarItem
 {
-    Q_OBJECT
 public:
-    explicit Todo(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    Todo(const QString &calId, const QString &itemUid);
     QString type() const override;
     QVariant data(int role) const override;
-    QString toICal() const override;
-    CalendarItem* clone(QObject *parent = nullptr) const override;
+    CalendarItem* clone() const override;
 
 
     QDateTime dtStart() const override;
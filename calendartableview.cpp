@@ -4,9 +4,11 @@
 #include <QDebug>
 
 CalendarTableView::CalendarTableView(Cal* cal, QWidget* parent)
-    : ViewInterface(cal ? cal->parentCollection() : nullptr, parent), m_tableView(new QTableView(this))
+    : ViewInterface(cal ? cal->parentCollection() : nullptr, parent), m_tableView(new QTableView(this)),
+      m_proxy(new CategoryFilterProxy(this))
 {
-    m_tableView->setModel(cal);
+    m_proxy->setSourceModel(cal);
+    m_tableView->setModel(m_proxy);
     m_activeCal = cal;
 
     QVBoxLayout* layout = new QVBoxLayout(this);
@@ -33,7 +35,7 @@ void CalendarTableView::setActiveCal(Cal* cal)
 {
     if (m_activeCal != cal) {
         m_activeCal = cal;
-        m_tableView->setModel(cal);
+        m_proxy->setSourceModel(cal);
         emit calChanged(cal);
         qDebug() << "CalendarTableView: Switched activeCal to" << (cal ? cal->id() : "null");
     }
@@ -51,9 +53,14 @@ void CalendarTableView::refresh()
     qDebug() << "CalendarTableView: Refreshed view for" << (m_activeCal ? m_activeCal->name() : "null");
 }
 
+void CalendarTableView::setCategoryFilter(const CategoryIndex::Filter &filter)
+{
+    m_proxy->setCategoryFilter(filter);
+}
+
 QSharedPointer<CalendarItem> CalendarTableView::selectedItem() const
 {
-    QModelIndex index = m_tableView->currentIndex();
+    QModelIndex index = m_proxy->mapToSource(m_tableView->currentIndex());
     if (!index.isValid() || !m_activeCal || index.row() >= m_activeCal->items().size()) {
         return QSharedPointer<CalendarItem>();
     }
@@ -70,7 +77,8 @@ void CalendarTableView::onSelectionChanged(const QItemSelection& selected, const
 
     QModelIndexList indexes = m_tableView->selectionModel()->selectedRows();
     QList<QSharedPointer<CalendarItem>> items;
-    for (const QModelIndex& index : indexes) {
+    for (const QModelIndex& proxyIndex : indexes) {
+        const QModelIndex index = m_proxy->mapToSource(proxyIndex);
         if (index.row() >= 0 && index.row() < m_activeCal->items().size()) {
             items.append(m_activeCal->items().at(index.row()));
         }
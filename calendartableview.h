@@ -2,6 +2,7 @@
 #define CALENDARTABLEVIEW_H
 
 #include "viewinterface.h"
+#include "categoryfilterproxy.h"
 #include <QTableView>
 
 class CalendarTableView : public ViewInterface {
@@ -17,11 +18,15 @@ public:
     // Legacy method for compatibility
     QSharedPointer<CalendarItem> selectedItem() const;
 
+    // Rows outside the filter are hidden; an empty filter shows everything
+    void setCategoryFilter(const CategoryIndex::Filter &filter);
+
 private slots:
     void onSelectionChanged(const QItemSelection& selected, const QItemSelection& deselected);
 
 private:
     QTableView* m_tableView;
+    CategoryFilterProxy* m_proxy; // Between the active Cal and the table
 };
 
 #endif // CALENDARTABLEVIEW_H
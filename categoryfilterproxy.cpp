@@ -0,0 +1,78 @@
+#include "categoryfilterproxy.h"
+#include "cal.h"
+#include <QDebug>
+#include <utility>
+
+CategoryFilterProxy::CategoryFilterProxy(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    setSortRole(Cal::SortRole);
+    m_catchUpTimer.setSingleShot(true);
+    m_catchUpTimer.setInterval(0);
+    connect(&m_catchUpTimer, &QTimer::timeout, this, &CategoryFilterProxy::catchUp);
+}
+
+void CategoryFilterProxy::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    m_cal = qobject_cast<Cal*>(sourceModel);
+    compileFilter(); // Another calendar may use another dictionary
+    m_checkedRevision = CalendarItem::latestRevision(); // Every row is filtered afresh
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+void CategoryFilterProxy::setCategoryFilter(const CategoryIndex::Filter &filter)
+{
+    m_filter = filter;
+    compileFilter();
+    m_checkedRevision = CalendarItem::latestRevision();
+    invalidateFilter();
+    qDebug() << "CategoryFilterProxy: Filter all" << filter.all << "any" << filter.any << "none" << filter.none
+             << "-" << rowCount() << "rows";
+}
+
+void CategoryFilterProxy::compileFilter()
+{
+    m_compiled = m_cal ? m_cal->categoryIndex()->compile(m_filter) : CategoryIndex::CompiledFilter();
+}
+
+void CategoryFilterProxy::scheduleCatchUp() const
+{
+    if (CalendarItem::latestRevision() != m_checkedRevision && !m_catchUpTimer.isActive()) {
+        m_catchUpTimer.start();
+    }
+}
+
+void CategoryFilterProxy::catchUp()
+{
+    // Rows whose item has a newer revision than the last check and whose verdict no longer matches
+    m_catchUpTimer.stop();
+    const quint64 latest = CalendarItem::latestRevision();
+    if (latest == m_checkedRevision) return;
+    const quint64 checked = std::exchange(m_checkedRevision, latest);
+    if (!m_cal || m_filter.isEmpty()) return;
+    const QList<QSharedPointer<CalendarItem>> items = m_cal->items();
+    for (int row = 0; row < items.size(); ++row) {
+        if (items.at(row)->revision() <= checked) continue;
+        const bool shown = mapFromSource(m_cal->index(row, 0)).isValid();
+        if (filterAcceptsRow(row, QModelIndex()) != shown) {
+            invalidateRowsFilter(); // Tests cached bits only, and keeps the sort
+            return;
+        }
+    }
+}
+
+QVariant CategoryFilterProxy::data(const QModelIndex &index, int role) const
+{
+    scheduleCatchUp();
+    return QSortFilterProxyModel::data(index, role);
+}
+
+bool CategoryFilterProxy::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (sourceParent.isValid() || !m_cal || m_filter.isEmpty()) return true;
+    const QBitArray &bits = m_cal->categoryBits(sourceRow); // May add this row's categories to the dictionary
+    if (m_compiled.dictionarySize != m_cal->categoryIndex()->size()) {
+        m_compiled = m_cal->categoryIndex()->compile(m_filter);
+    }
+    return m_compiled.matches(bits);
+}
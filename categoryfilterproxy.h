@@ -0,0 +1,44 @@
+#ifndef CATEGORYFILTERPROXY_H
+#define CATEGORYFILTERPROXY_H
+
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include "categoryindex.h"
+
+class Cal;
+
+// Shows the rows of a Cal that pass a category filter. Rows are tested against the calendar's cached
+// category bits, so refiltering a large calendar never reads an incidence. Sorts by Cal::SortRole.
+// Items edited in place emit no dataChanged; reading the proxy schedules a catch-up by revision for the
+// next event loop pass, which refilters only if an edited row now falls on the other side of the filter.
+class CategoryFilterProxy : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit CategoryFilterProxy(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override; // Expects a Cal
+    Cal *sourceCal() const { return m_cal; }
+
+    CategoryIndex::Filter categoryFilter() const { return m_filter; }
+    void setCategoryFilter(const CategoryIndex::Filter &filter);
+    void catchUp(); // Applies in-place edits now instead of on the next event loop pass
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    void compileFilter();
+    void scheduleCatchUp() const;
+
+    Cal *m_cal = nullptr;
+    CategoryIndex::Filter m_filter;
+    mutable CategoryIndex::CompiledFilter m_compiled; // Ids in the source calendar's dictionary, recompiled as it grows
+    quint64 m_checkedRevision = 0; // CalendarItem::latestRevision() the filtered rows are known to reflect
+    mutable QTimer m_catchUpTimer;
+};
+
+#endif // CATEGORYFILTERPROXY_H
@@ -0,0 +1,72 @@
+#include "categoryindex.h"
+
+int CategoryIndex::id(const QString &category)
+{
+    const QString key = category.trimmed().toCaseFolded();
+    const auto it = m_ids.constFind(key);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+    const int id = m_names.size();
+    m_names.append(category.trimmed());
+    m_ids.insert(key, id);
+    return id;
+}
+
+int CategoryIndex::find(const QString &category) const
+{
+    return m_ids.value(category.trimmed().toCaseFolded(), -1);
+}
+
+QBitArray CategoryIndex::bitsFor(const QStringList &categories)
+{
+    QBitArray bits;
+    for (const QString &category : categories) {
+        if (category.trimmed().isEmpty()) continue;
+        const int bit = id(category);
+        if (bit >= bits.size()) {
+            bits.resize(bit + 1); // Sized to the highest id the item uses, not the dictionary
+        }
+        bits.setBit(bit);
+    }
+    return bits;
+}
+
+CategoryIndex::CompiledFilter CategoryIndex::compile(const Filter &filter) const
+{
+    // Looked up, not interned: a filter naming categories nobody uses must not grow the dictionary
+    CompiledFilter compiled;
+    compiled.dictionarySize = size();
+    for (const QString &category : filter.all) {
+        const int bit = find(category);
+        if (bit < 0) compiled.matchesNothing = true;
+        compiled.all.append(bit);
+    }
+    for (const QString &category : filter.any) {
+        const int bit = find(category);
+        if (bit >= 0) compiled.any.append(bit);
+    }
+    if (!filter.any.isEmpty() && compiled.any.isEmpty()) compiled.matchesNothing = true;
+    for (const QString &category : filter.none) {
+        const int bit = find(category);
+        if (bit >= 0) compiled.none.append(bit);
+    }
+    return compiled;
+}
+
+bool CategoryIndex::CompiledFilter::matches(const QBitArray &bits) const
+{
+    if (matchesNothing) return false;
+    auto has = [&bits](int bit) { return bit < bits.size() && bits.testBit(bit); };
+    for (int bit : all) {
+        if (!has(bit)) return false;
+    }
+    for (int bit : none) {
+        if (has(bit)) return false;
+    }
+    if (any.isEmpty()) return true;
+    for (int bit : any) {
+        if (has(bit)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,50 @@
+#ifndef CATEGORYINDEX_H
+#define CATEGORYINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+// Dictionary of the categories used across a collection. Each category gets a small id, so an item's
+// categories become a bitset and filters are answered from bits instead of the incidences' string lists.
+// Names compare case-insensitively; the first spelling seen is the one reported.
+class CategoryIndex
+{
+public:
+    // Category filter: an item matches if it has all of `all`, at least one of `any` (when given) and none of `none`
+    struct Filter {
+        QStringList all;
+        QStringList any;
+        QStringList none;
+
+        bool isEmpty() const { return all.isEmpty() && any.isEmpty() && none.isEmpty(); }
+    };
+
+    // A filter resolved to category ids. Terms the dictionary has not seen are settled at compile time:
+    // no item has them yet. Once the dictionary grows (dictionarySize != size()) it must be compiled again.
+    struct CompiledFilter {
+        QList<int> all;
+        QList<int> any;
+        QList<int> none;
+        bool matchesNothing = false; // An unknown `all` term, or only unknown `any` terms
+        int dictionarySize = 0;
+
+        bool matches(const QBitArray &bits) const;
+    };
+
+    int id(const QString &category); // Adds the category if it is new
+    int find(const QString &category) const; // -1 if never seen
+    QString name(int id) const { return m_names.value(id); }
+    QStringList names() const { return m_names; }
+    int size() const { return m_names.size(); }
+
+    QBitArray bitsFor(const QStringList &categories);
+    CompiledFilter compile(const Filter &filter) const;
+
+private:
+    QHash<QString, int> m_ids; // Case-folded name -> id
+    QStringList m_names;
+};
+
+#endif // CATEGORYINDEX_H
@@ -1,8 +1,10 @@
 #include "collection.h"
+#include "overlapdetector.h"
 #include <QDebug>
+#include <algorithm>
 
 Collection::Collection(const QString &id, const QString &name, QObject *parent)
-    : QAbstractTableModel(parent), m_id(id), m_name(name)
+    : QAbstractTableModel(parent), m_id(id), m_name(name), m_overlaps(new OverlapDetector(this))
 {
     // Stubbed dummy data
     //addCal(new Cal("cal1", "Test Calendar", this));
@@ -74,3 +76,56 @@ QList<Cal*> Collection::calendars() const
     }
     return rawPointers;
 }
+
+QList<QSharedPointer<CalendarItem>> Collection::itemsInRange(const QDateTime &from, const QDateTime &to) const
+{
+    // Each calendar's hits are already ordered by start; merge them pairwise into one list
+    QList<std::pair<qint64, QSharedPointer<CalendarItem>>> merged;
+    QList<std::pair<qint64, QSharedPointer<CalendarItem>>> hits;
+    QList<std::pair<qint64, QSharedPointer<CalendarItem>>> combined;
+    for (const auto &cal : m_calendars) {
+        QList<qint64> starts;
+        const QList<QSharedPointer<CalendarItem>> items = cal->itemsInRange(from, to, &starts);
+        if (items.isEmpty()) continue;
+        hits.clear();
+        hits.reserve(items.size());
+        for (int i = 0; i < items.size(); ++i) {
+            hits.append({starts.at(i), items.at(i)});
+        }
+        combined.resize(merged.size() + hits.size());
+        std::merge(merged.cbegin(), merged.cend(), hits.cbegin(), hits.cend(), combined.begin(),
+                   [](const auto &a, const auto &b) { return a.first < b.first; });
+        merged.swap(combined);
+    }
+
+    QList<QSharedPointer<CalendarItem>> items;
+    items.reserve(merged.size());
+    for (const auto &hit : std::as_const(merged)) {
+        items.append(hit.second);
+    }
+    return items;
+}
+
+QList<QSharedPointer<CalendarItem>> Collection::search(const QString &query) const
+{
+    QList<QSharedPointer<CalendarItem>> items;
+    for (const auto &cal : m_calendars) {
+        items += cal->search(query);
+    }
+    return items;
+}
+
+QList<QSharedPointer<CalendarItem>> Collection::itemsMatching(const CategoryIndex::Filter &filter)
+{
+    // Scanning fills in category bits, which may teach the dictionary a term of the filter; then scan again
+    QList<QSharedPointer<CalendarItem>> items;
+    CategoryIndex::CompiledFilter compiled;
+    do {
+        compiled = m_categories.compile(filter);
+        items.clear();
+        for (const auto &cal : m_calendars) {
+            items += cal->itemsMatching(compiled);
+        }
+    } while (compiled.dictionarySize != m_categories.size());
+    return items;
+}
@@ -3,9 +3,12 @@
 
 #include <QAbstractTableModel>
 #include "cal.h"
+#include "categoryindex.h"
 #include <QList>
 #include <QSharedPointer>
 
+class OverlapDetector;
+
 class Collection : public QAbstractTableModel
 {
     Q_OBJECT
@@ -26,6 +29,19 @@ public:
     QList<Cal*> calendars() const; // Returns raw pointers for compatibility
     void clearCalendars(); // New method to clear calendars
 
+    // Items of every calendar overlapping [from, to), ordered by start; each calendar answers from its time index
+    QList<QSharedPointer<CalendarItem>> itemsInRange(const QDateTime &from, const QDateTime &to) const;
+    // Cal::search over every calendar, calendar by calendar
+    QList<QSharedPointer<CalendarItem>> search(const QString &query) const;
+
+    // Category ids shared by all calendars of the collection
+    CategoryIndex *categoryIndex() { return &m_categories; }
+    // Items of every calendar passing an AND/OR/NOT category filter, answered from per-row category bits
+    QList<QSharedPointer<CalendarItem>> itemsMatching(const CategoryIndex::Filter &filter);
+
+    // Flags overlapping events of all calendars as they change; see CalendarItem::isDoubleBooked()
+    OverlapDetector *overlapDetector() const { return m_overlaps; }
+
 signals:
     void calendarsChanged();
 
@@ -33,6 +49,8 @@ private:
     QString m_id; // Unique across app
     QString m_name; // User-facing name
     QList<QSharedPointer<Cal>> m_calendars; // Owned by Collection
+    CategoryIndex m_categories;
+    OverlapDetector *m_overlaps; // Child object
 };
 
 #endif // COLLECTION_H
@@ -7,6 +7,7 @@
 #include <QDebug>
 #include <algorithm> // For std::sort
 #include <QSqlDatabase>
+#include <QSet>
 
 
 CollectionController::CollectionController(QObject *parent)
@@ -48,7 +49,11 @@ void CollectionController::loadCollection(const QString &name, SyncBackend *init
                 info.priority = backendConfig.priority;
                 info.syncOnOpen = backendConfig.syncOnOpen;
                 if (backendConfig.type == "local") {
-                    info.backend = new LocalBackend(backendConfig.details["rootPath"].toString(), this);
+                    LocalBackend *local = new LocalBackend(backendConfig.details["rootPath"].toString(), this);
+                    local->setLoadWorkerCount(backendConfig.details.value("loadWorkers", 0).toInt());
+                    local->setHashAlgorithm(ContentHash::algorithmFromName(backendConfig.details.value("contentHash").toString()));
+                    local->setLazyLoading(backendConfig.details.value("lazyLoad", false).toBool());
+                    info.backend = local;
                 } else if (backendConfig.type == "caldav") {
                     info.backend = new CalDAVBackend(
                         backendConfig.details["serverUrl"].toString(),
@@ -62,6 +67,9 @@ void CollectionController::loadCollection(const QString &name, SyncBackend *init
             m_backends[id] = loadedBackends;
             isTransient = false; // Loaded collections are persistent
             m_collectionToKalbPath[id] = kalbPath;
+            for (const BackendInfo &info : loadedBackends) {
+                configureSnapshot(id, info.backend);
+            }
             qDebug() << "CollectionController: Parsed collection id:" << id << "name:" << loadedName;
             Collection *col = new Collection(id, loadedName, this);
             m_collections.insert(id, col);
@@ -105,6 +113,7 @@ void CollectionController::loadCollection(const QString &name, SyncBackend *init
                 QString savedPath = configManager.saveBackendConfig(id, name, backendList);
                 if (!savedPath.isEmpty()) {
                     m_collectionToKalbPath[id] = savedPath;
+                    configureSnapshot(id, initialBackend);
                 } else {
                     qDebug() << "CollectionController: Failed to save non-transient collection" << id;
                 }
@@ -114,7 +123,7 @@ void CollectionController::loadCollection(const QString &name, SyncBackend *init
     }
 
     // Connect signals and start sync for all backends with syncOnOpen
-    int syncCount = 0;
+    QList<SyncBackend*> syncBackends;
     for (BackendInfo &info : m_backends[id]) {
         SyncBackend *backend = info.backend;
         connect(backend, &SyncBackend::errorOccurred, this, [](const QString &error) {
@@ -123,14 +132,24 @@ void CollectionController::loadCollection(const QString &name, SyncBackend *init
         if (info.syncOnOpen) {
             connect(backend, &SyncBackend::calendarDiscovered, this, &CollectionController::onCalendarDiscovered);
             connect(backend, &SyncBackend::itemLoaded, this, &CollectionController::onItemLoaded);
+            connect(backend, &SyncBackend::itemsLoaded, this, &CollectionController::onItemsLoaded);
             connect(backend, &SyncBackend::calendarLoaded, this, &CollectionController::onCalendarLoaded);
             connect(backend, &SyncBackend::syncCompleted, this, &CollectionController::onSyncCompleted);
-            syncCount++;
-            backend->startSync(id);
+            connect(backend, &SyncBackend::itemsAdded, this, &CollectionController::onItemsAdded);
+            connect(backend, &SyncBackend::itemsUpdated, this, &CollectionController::onItemsUpdated);
+            connect(backend, &SyncBackend::itemsRemoved, this, &CollectionController::onItemsRemoved);
+            if (LocalBackend *local = qobject_cast<LocalBackend*>(backend)) {
+                local->setWatchEnabled(true); // Pick up edits made by other tools while the collection is open
+            }
+            syncBackends.append(backend);
         }
     }
-    if (syncCount > 0) {
-        m_pendingSyncs[id] = syncCount;
+    // Count before starting: backends may complete asynchronously or immediately
+    if (!syncBackends.isEmpty()) {
+        m_pendingSyncs[id] = syncBackends.size();
+        for (SyncBackend *backend : syncBackends) {
+            backend->startSync(id);
+        }
     }
 }
 
@@ -198,6 +217,19 @@ bool CollectionController::saveCollection(const QString &collectionId, const QSt
 }
 
 
+void CollectionController::configureSnapshot(const QString &collectionId, SyncBackend *backend) const
+{
+    LocalBackend *local = qobject_cast<LocalBackend*>(backend);
+    QString kalbPath = m_collectionToKalbPath.value(collectionId);
+    if (!local || kalbPath.isEmpty()) {
+        return; // Transient collections have nowhere to keep a snapshot
+    }
+    // Next to the .kalb like the delta journal; one file per backend root so two local backends never share one
+    QByteArray rootKey = QDir(local->rootPath()).absolutePath().toUtf8();
+    QString rootHash = QString::number(ContentHash::xxHash64(rootKey.constData(), rootKey.size()), 16);
+    local->setSnapshotPath(QFileInfo(kalbPath).absolutePath() + "/snapshot." + collectionId + "." + rootHash + ".bin");
+}
+
 bool CollectionController::isTransient(const QString &collectionId) const
 {
     return !m_collectionToKalbPath.contains(collectionId);
@@ -235,12 +267,38 @@ void CollectionController::attachLocalBackend(const QString &collectionId, SyncB
 
     QList<Cal*> calendars = col->calendars();
     localBackend->storeCalendars(collectionId, calendars);
+    localBackend->beginCommit();
     for (Cal *cal : calendars) {
         localBackend->storeItems(cal, cal->items());
     }
+    localBackend->endCommit();
     qDebug() << "CollectionController: Synced" << calendars.size() << "calendars to local backend";
 }
 
+bool CollectionController::importIcsFile(const QString &collectionId, const QString &calId, const QString &filePath, bool explode)
+{
+    Cal *cal = m_calMap.value(calId);
+    if (!cal || !m_collections.contains(collectionId)) {
+        qDebug() << "CollectionController: Cannot import, calendar" << calId << "not found in" << collectionId;
+        return false;
+    }
+
+    LocalBackend *local = nullptr;
+    for (const BackendInfo &info : m_backends.value(collectionId)) {
+        if ((local = qobject_cast<LocalBackend*>(info.backend))) break;
+    }
+    if (!local) {
+        qDebug() << "CollectionController: No local backend to import into for" << collectionId;
+        return false;
+    }
+
+    // Attached backends are not connected for loading; imported batches arrive through the change feed
+    connect(local, &SyncBackend::itemsAdded, this, &CollectionController::onItemsAdded, Qt::UniqueConnection);
+    connect(local, &LocalBackend::importProgress, this, &CollectionController::importProgress, Qt::UniqueConnection);
+    connect(local, &LocalBackend::importFinished, this, &CollectionController::importFinished, Qt::UniqueConnection);
+    return local->importIcsFile(filePath, CalendarMetadata{cal->id(), cal->name()}, explode);
+}
+
 const QMap<QString, QList<SyncBackend*>> &CollectionController::backends() const
 {
     static QMap<QString, QList<SyncBackend*>> rawBackends;
@@ -293,28 +351,40 @@ void CollectionController::onCalendarDiscovered(const QString &collectionId, con
     emit calendarAdded(cal);
 }
 
-void CollectionController::onItemLoaded(Cal *tempCal, QSharedPointer<CalendarItem> item)
+void CollectionController::onItemLoaded(Cal *tempCal, QSharedPointer<CalendarItem> item, const QString &versionIdentifier)
 {
     Cal *realCal = m_calMap.value(tempCal->id());
     if (!realCal) {
         qWarning() << "CollectionController: No real Cal for" << tempCal->id() << "on item load";
         return;
     }
+    const QSharedPointer<CalendarItem> previous = realCal->findItem(item->id());
+    const QString previousVersion = previous ? previous->versionIdentifier() : QString();
     realCal->addItem(item);
+    recordLoadedVersion(realCal, item, previousVersion, versionIdentifier);
+    emit itemAdded(realCal, item);
+}
 
-    // If the item is not dirty, fetch the version identifier from the backend.
+void CollectionController::recordLoadedVersion(Cal *realCal, const QSharedPointer<CalendarItem> &item,
+                                               const QString &previousVersion, const QString &versionIdentifier)
+{
+    // If the item is not dirty, record the version identifier the backend computed while loading.
     if (!item->isDirty()) {
-        // For simplicity, assume a single backend per collection.
-        // Extract collection ID from the cal's id (assuming format "col0_calendarName").
-        QString collectionId = realCal->id().split("_").first();
-        QList<BackendInfo> backends = m_backends.value(collectionId);
-        if (!backends.isEmpty()) {
-            SyncBackend *backend = backends.first().backend;
-            QString newVer = backend->fetchItemVersionIdentifier(realCal->id(), item->id());
-            QString oldVer = item->versionIdentifier();
-            if (!oldVer.isEmpty() && oldVer != newVer) {
+        QString newVer = versionIdentifier;
+        if (newVer.isEmpty()) {
+            // Backend did not supply one; ask it (may hit the disk or network).
+            // For simplicity, assume a single backend per collection.
+            QString collectionId = IdTable::collectionIdOf(realCal->id());
+            QList<BackendInfo> backends = m_backends.value(collectionId);
+            if (!backends.isEmpty()) {
+                newVer = backends.first().backend->fetchItemVersionIdentifier(realCal->id(), item->id());
+            }
+        }
+        if (!newVer.isEmpty()) {
+            // Compare with what the copy this load replaces was read from; only then store the new hash
+            if (!previousVersion.isEmpty() && previousVersion != newVer) {
                 qDebug() << "CollectionController: Conflict detected for item" << item->id()
-                << ": stored version =" << oldVer << ", new version =" << newVer;
+                << ": stored version =" << previousVersion << ", new version =" << newVer;
                 item->setConflictStatus(CalendarItem::ConflictStatus::Pending);
             } else {
                 item->setConflictStatus(CalendarItem::ConflictStatus::None);
@@ -324,11 +394,8 @@ void CollectionController::onItemLoaded(Cal *tempCal, QSharedPointer<CalendarIte
                      << item->id() << "to" << newVer;
         }
     }
-    emit itemAdded(realCal, item);
 }
 
-
-
 void CollectionController::onCalendarLoaded(Cal *tempCal)
 {
     Cal *realCal = m_calMap.value(tempCal->id());
@@ -345,6 +412,16 @@ void CollectionController::onSyncCompleted(const QString &collectionId)
     m_pendingSyncs[collectionId]--;
     if (m_pendingSyncs[collectionId] <= 0) {
         qDebug() << "CollectionController: All backends completed for" << collectionId;
+        if (Collection *col = m_collections.value(collectionId)) {
+            qsizetype bytes = 0;
+            int items = 0;
+            for (Cal *cal : col->calendars()) {
+                bytes += cal->memoryFootprint();
+                items += cal->rowCount();
+            }
+            qDebug() << "CollectionController: Collection" << collectionId << "holds" << items << "items in ~"
+                     << bytes / 1024 << "KiB (" << (items ? bytes / items : 0) << "bytes/item)";
+        }
         m_pendingSyncs.remove(collectionId);
         emit loadingProgress(100); // Stub for Stage 1
         emit allSyncsCompleted(collectionId); // Emit new signal
@@ -361,11 +438,81 @@ void CollectionController::onCalendarsLoaded(const QString &collectionId, const
     // Do nothing—let onCalendarDiscovered handle it
 }
 
-void CollectionController::onItemsLoaded(Cal *cal, QList<QSharedPointer<CalendarItem>> items)
+void CollectionController::onItemsLoaded(Cal *tempCal, QList<QSharedPointer<CalendarItem>> items)
+{
+    Cal *realCal = m_calMap.value(tempCal->id());
+    if (!realCal) {
+        qWarning() << "CollectionController: No real Cal for" << tempCal->id() << "on batch load";
+        return;
+    }
+    // Versions of the copies this batch replaces, read before addItems swaps them out
+    QList<QString> previousVersions;
+    previousVersions.reserve(items.size());
+    for (const QSharedPointer<CalendarItem> &item : items) {
+        const QSharedPointer<CalendarItem> previous = realCal->findItem(item->id());
+        previousVersions.append(previous ? previous->versionIdentifier() : QString());
+    }
+    realCal->addItems(items);
+    for (int i = 0; i < items.size(); ++i) {
+        recordLoadedVersion(realCal, items.at(i), previousVersions.at(i), items.at(i)->versionIdentifier()); // Carried from the parse
+    }
+    qDebug() << "CollectionController: Added batch of" << items.size() << "items to" << realCal->id();
+    emit itemsLoaded(realCal, items); // One view refresh per batch instead of per item
+}
+
+void CollectionController::onItemsAdded(const QString &calId, QList<QSharedPointer<CalendarItem>> items)
+{
+    Cal *realCal = m_calMap.value(calId);
+    if (!realCal) {
+        qWarning() << "CollectionController: No real Cal for" << calId << "on external add";
+        return;
+    }
+    realCal->updateItems(items); // Appends when new, replaces if a file was renamed back in
+    qDebug() << "CollectionController: Added" << items.size() << "externally created items to" << calId;
+    emit itemsLoaded(realCal, items);
+}
+
+void CollectionController::onItemsUpdated(const QString &calId, QList<QSharedPointer<CalendarItem>> items)
 {
-    Q_UNUSED(cal);
-    Q_UNUSED(items);
-    qDebug() << "CollectionController: Ignoring legacy itemsLoaded for" << cal->id();
-    // Do nothing—let onItemLoaded handle it
+    Cal *realCal = m_calMap.value(calId);
+    if (!realCal) {
+        qWarning() << "CollectionController: No real Cal for" << calId << "on external update";
+        return;
+    }
+    QList<QSharedPointer<CalendarItem>> applied;
+    for (const QSharedPointer<CalendarItem> &item : items) {
+        const QSharedPointer<CalendarItem> existing = realCal->findItem(item->id());
+        if (existing && existing->isDirty()) {
+            // Local edits pending; keep them and let the user resolve against the new file
+            qDebug() << "CollectionController: External edit to dirty item" << item->id() << "- marking conflict";
+            existing->setConflictStatus(CalendarItem::ConflictStatus::Pending);
+            continue;
+        }
+        applied.append(item);
+    }
+    realCal->updateItems(applied);
+    qDebug() << "CollectionController: Applied" << applied.size() << "of" << items.size() << "external updates to" << calId;
+    emit itemsLoaded(realCal, applied);
 }
 
+void CollectionController::onItemsRemoved(const QString &calId, const QStringList &itemIds)
+{
+    Cal *realCal = m_calMap.value(calId);
+    if (!realCal) {
+        qWarning() << "CollectionController: No real Cal for" << calId << "on external removal";
+        return;
+    }
+    QStringList removable;
+    for (const QString &itemId : itemIds) {
+        const QSharedPointer<CalendarItem> item = realCal->findItem(itemId);
+        if (!item) continue;
+        if (item->isDirty()) {
+            item->setConflictStatus(CalendarItem::ConflictStatus::Pending); // Deleted on disk but edited here
+            continue;
+        }
+        removable.append(itemId);
+    }
+    realCal->removeItems(removable);
+    qDebug() << "CollectionController: Removed" << removable.size() << "of" << itemIds.size()
+             << "externally deleted items from" << calId;
+}
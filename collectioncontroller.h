@@ -26,28 +26,39 @@ public:
     bool saveCollection(const QString &collectionId, const QString &kalbPath = QString());
     void unloadCollection(const QString &collectionId); // New method
     void attachLocalBackend(const QString &collectionId, SyncBackend *localBackend);
+    // Streams a .ics file into a calendar through the collection's first local backend
+    bool importIcsFile(const QString &collectionId, const QString &calId, const QString &filePath, bool explode);
 
 signals:
     void collectionAdded(Collection *collection);
     void calendarsLoaded(const QString &collectionId, const QList<CalendarMetadata> &calendars);
-    void itemsLoaded(Cal *cal, QList<QSharedPointer<CalendarItem>> items); // Legacy
+    void itemsLoaded(Cal *cal, QList<QSharedPointer<CalendarItem>> items); // One per backend batch
     void allSyncsCompleted(const QString &collectionId); // New signal
     void calendarAdded(Cal *cal);
     void itemAdded(Cal *cal, QSharedPointer<CalendarItem> item);
     void calendarLoaded(Cal *cal);
     void loadingProgress(int progress);
     void allBackendsCompleted(const QString &collectionId);
+    void importProgress(const QString &calId, qint64 bytesRead, qint64 totalBytes);
+    void importFinished(const QString &calId, int imported, int failed);
 
 private slots:
     void onCalendarsLoaded(const QString &collectionId, const QList<CalendarMetadata> &calendars);
     void onItemsLoaded(Cal *cal, QList<QSharedPointer<CalendarItem>> items);
     void onDataLoaded();
     void onCalendarDiscovered(const QString &collectionId, const CalendarMetadata &calendar);
-    void onItemLoaded(Cal *cal, QSharedPointer<CalendarItem> item);
+    void onItemLoaded(Cal *cal, QSharedPointer<CalendarItem> item, const QString &versionIdentifier);
     void onCalendarLoaded(Cal *cal);
     void onSyncCompleted(const QString &collectionId);
+    void onItemsAdded(const QString &calId, QList<QSharedPointer<CalendarItem>> items);
+    void onItemsUpdated(const QString &calId, QList<QSharedPointer<CalendarItem>> items);
+    void onItemsRemoved(const QString &calId, const QStringList &itemIds);
 
 private:
+    void recordLoadedVersion(Cal *realCal, const QSharedPointer<CalendarItem> &item, const QString &previousVersion,
+                             const QString &versionIdentifier);
+    void configureSnapshot(const QString &collectionId, SyncBackend *backend) const;
+
     QMap<QString, Collection*> m_collections;
     QMap<QString, QList<BackendInfo>> m_backends;
     QMap<QString, Cal*> m_calMap;
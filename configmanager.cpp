@@ -57,6 +57,15 @@ QString ConfigManager::saveBackendConfig(const QString &collectionId, const QStr
             QString rootPath = local->rootPath();
             QString relativePath = QDir(kalbDir).relativeFilePath(rootPath);
             writer.writeTextElement("RootPath", relativePath.isEmpty() ? "." : relativePath);
+            if (local->loadWorkerCount() > 0) {
+                writer.writeTextElement("LoadWorkers", QString::number(local->loadWorkerCount()));
+            }
+            if (local->hashAlgorithm() != ContentHash::Algorithm::Md5) {
+                writer.writeTextElement("ContentHash", ContentHash::algorithmName(local->hashAlgorithm()));
+            }
+            if (local->lazyLoading()) {
+                writer.writeTextElement("LazyLoad", "true");
+            }
             writer.writeTextElement("priority", QString::number(info.priority));
             writer.writeTextElement("SyncOnOpen", info.syncOnOpen ? "true" : "false");
         } else if (CalDAVBackend *caldav = dynamic_cast<CalDAVBackend*>(backend)) {
@@ -146,6 +155,12 @@ QVariantMap ConfigManager::loadConfig(const QString &collectionId, const QString
                             } else {
                                 backend.details["rootPath"] = rootPath;
                             }
+                        } else if (reader.name() == "LoadWorkers") {
+                            backend.details["loadWorkers"] = reader.readElementText().toInt();
+                        } else if (reader.name() == "ContentHash") {
+                            backend.details["contentHash"] = reader.readElementText();
+                        } else if (reader.name() == "LazyLoad") {
+                            backend.details["lazyLoad"] = reader.readElementText() == "true";
                         } else if (reader.name() == "ServerUrl") {
                             backend.details["serverUrl"] = reader.readElementText();
                         } else if (reader.name() == "Username") {
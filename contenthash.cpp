@@ -0,0 +1,130 @@
+#include "contenthash.h"
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 Prime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 Prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 Prime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 Prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 Prime5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads; memcpy keeps unaligned reads well-defined
+inline quint64 read64(const uchar *p)
+{
+    quint64 value;
+    std::memcpy(&value, p, sizeof(value));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    value = qbswap(value);
+#endif
+    return value;
+}
+
+inline quint32 read32(const uchar *p)
+{
+    quint32 value;
+    std::memcpy(&value, p, sizeof(value));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    value = qbswap(value);
+#endif
+    return value;
+}
+
+inline quint64 xxRound(quint64 acc, quint64 input)
+{
+    acc += input * Prime2;
+    acc = rotl(acc, 31);
+    return acc * Prime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    acc ^= xxRound(0, value);
+    return acc * Prime1 + Prime4;
+}
+
+} // namespace
+
+quint64 ContentHash::xxHash64(const char *data, qsizetype length, quint64 seed)
+{
+    // XXH64 as specified at https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    const uchar *end = p + length;
+    quint64 hash;
+
+    if (length >= 32) {
+        const uchar *limit = end - 32;
+        quint64 v1 = seed + Prime1 + Prime2;
+        quint64 v2 = seed + Prime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - Prime1;
+        do {
+            v1 = xxRound(v1, read64(p)); p += 8;
+            v2 = xxRound(v2, read64(p)); p += 8;
+            v3 = xxRound(v3, read64(p)); p += 8;
+            v4 = xxRound(v4, read64(p)); p += 8;
+        } while (p <= limit);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + Prime5;
+    }
+
+    hash += static_cast<quint64>(length);
+
+    while (p + 8 <= end) {
+        hash ^= xxRound(0, read64(p));
+        hash = rotl(hash, 27) * Prime1 + Prime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= static_cast<quint64>(read32(p)) * Prime1;
+        hash = rotl(hash, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= static_cast<quint64>(*p) * Prime5;
+        hash = rotl(hash, 11) * Prime1;
+        ++p;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+QString ContentHash::versionIdentifier(const QByteArray &data, Algorithm algorithm)
+{
+    if (algorithm == Algorithm::XxHash64) {
+        return QString::number(xxHash64(data.constData(), data.size()), 16).rightJustified(16, '0');
+    }
+    // Use MD5 for a lightweight hash; collisions are extremely unlikely in our use case.
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex());
+}
+
+QString ContentHash::algorithmName(Algorithm algorithm)
+{
+    return algorithm == Algorithm::XxHash64 ? QStringLiteral("xxh64") : QStringLiteral("md5");
+}
+
+ContentHash::Algorithm ContentHash::algorithmFromName(const QString &name, Algorithm fallback)
+{
+    const QString lower = name.trimmed().toLower();
+    if (lower == "xxh64") return Algorithm::XxHash64;
+    if (lower == "md5") return Algorithm::Md5;
+    return fallback;
+}
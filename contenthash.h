@@ -0,0 +1,23 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QByteArray>
+#include <QString>
+
+// Content fingerprints used as version identifiers for locally stored items.
+class ContentHash
+{
+public:
+    enum class Algorithm {
+        Md5,     // Stable with identifiers recorded by earlier versions
+        XxHash64 // Non-cryptographic, several times faster on large archives
+    };
+
+    static QString versionIdentifier(const QByteArray &data, Algorithm algorithm = Algorithm::Md5);
+    static quint64 xxHash64(const char *data, qsizetype length, quint64 seed = 0);
+
+    static QString algorithmName(Algorithm algorithm);
+    static Algorithm algorithmFromName(const QString &name, Algorithm fallback = Algorithm::Md5);
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,20 @@
+#include "cowincidence.h"
+
+CowIncidence::CowIncidence(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    if (incidence) {
+        d = new Data;
+        d->incidence = incidence;
+    }
+}
+
+KCalendarCore::Incidence *CowIncidence::write()
+{
+    if (isNull()) return nullptr;
+    if (isShared()) {
+        Data *copy = new Data;
+        copy->incidence = KCalendarCore::Incidence::Ptr(d->incidence->clone());
+        d = copy; // Drops our reference to the shared data
+    }
+    return d->incidence.data();
+}
@@ -0,0 +1,40 @@
+#ifndef COWINCIDENCE_H
+#define COWINCIDENCE_H
+
+#include <KCalendarCore/Incidence>
+#include <QExplicitlySharedDataPointer>
+#include <QSharedData>
+
+// Copy-on-write handle to an incidence. Copies of a handle share one incidence until one of them asks
+// for write access, and only that one pays for the deep clone. Reads go through operator-> and as<T>(),
+// which only expose const access, so an edit cannot reach a shared incidence by accident.
+class CowIncidence
+{
+public:
+    CowIncidence() = default;
+    explicit CowIncidence(const KCalendarCore::Incidence::Ptr &incidence);
+
+    bool isNull() const { return !d || !d->incidence; }
+    explicit operator bool() const { return !isNull(); }
+    bool isShared() const { return d && d->ref.loadRelaxed() > 1; }
+    void reset() { d.reset(); }
+
+    const KCalendarCore::Incidence *operator->() const { return d->incidence.data(); }
+    template<typename T>
+    const T *as() const { return static_cast<const T*>(d->incidence.data()); }
+    // The incidence itself, e.g. to serialize it; edits must go through write()
+    KCalendarCore::Incidence::Ptr get() const { return d ? d->incidence : KCalendarCore::Incidence::Ptr(); }
+
+    // Clones the incidence first if another handle still shares it
+    KCalendarCore::Incidence *write();
+    template<typename T>
+    T *write() { return static_cast<T*>(write()); }
+
+private:
+    struct Data : QSharedData {
+        KCalendarCore::Incidence::Ptr incidence;
+    };
+    QExplicitlySharedDataPointer<Data> d;
+};
+
+#endif // COWINCIDENCE_H
@@ -99,6 +99,9 @@ void EditPane::updateSelection(const QList<QSharedPointer<CalendarItem>> &items)
 {
     m_items = items;
     m_modifiedRows.clear();
+    for (const auto &item : m_items) {
+        item->materialize(); // Lazily loaded items are read in full only once selected
+    }
 
     // Clear only the "Value" column (column 1), preserve "Property" column (column 0)
     for (int row = 0; row < m_propertiesTable->rowCount(); ++row) {
@@ -130,7 +133,7 @@ void EditPane::updateSelection(const QList<QSharedPointer<CalendarItem>> &items)
 
     if (m_items.size() == 1) {
         auto item = m_items.first();
-        m_propertiesTable->setItem(0, 1, new QTableWidgetItem(item->incidence()->summary()));
+        m_propertiesTable->setItem(0, 1, new QTableWidgetItem(item->summary()));
 
         // Start with QDateTimeEdit
         QDateTime startDt = item->dtStart();
@@ -172,7 +175,7 @@ void EditPane::updateSelection(const QList<QSharedPointer<CalendarItem>> &items)
         m_propertiesTable->setItem(4, 1, new QTableWidgetItem(item->categories().join(", ")));
         m_propertiesTable->setItem(5, 1, new QTableWidgetItem(item->description()));
     } else {
-        m_propertiesTable->setItem(0, 1, new QTableWidgetItem(summariesDiffer() ? "<Multiple Values>" : m_items[0]->incidence()->summary()));
+        m_propertiesTable->setItem(0, 1, new QTableWidgetItem(summariesDiffer() ? "<Multiple Values>" : m_items[0]->summary()));
 
         // Start
         QDateTime firstDtStart = m_items[0]->dtStart();
@@ -278,7 +281,7 @@ void EditPane::onApplyClicked()
         if (m_modifiedRows.contains(0)) {
             QTableWidgetItem *summaryItem = m_propertiesTable->item(0, 1);
             if (summaryItem && summaryItem->text() != "<Multiple Values>")
-                item->incidence()->setSummary(summaryItem->text());
+                item->setSummary(summaryItem->text());
         }
 
         if (m_modifiedRows.contains(1)) {
@@ -340,9 +343,9 @@ void EditPane::onCellChanged(int row, int column)
 bool EditPane::summariesDiffer() const
 {
     if (m_items.size() <= 1) return false;
-    QString firstSummary = m_items[0]->incidence()->summary();
+    QString firstSummary = m_items[0]->summary();
     for (int i = 1; i < m_items.size(); ++i) {
-        if (m_items[i]->incidence()->summary() != firstSummary) return true;
+        if (m_items[i]->summary() != firstSummary) return true;
     }
     return false;
 }
@@ -0,0 +1,212 @@
+#include "freebusy.h"
+#include "cal.h"
+#include "collection.h"
+#include <QDebug>
+#include <utility>
+
+FreeBusy::FreeBusy(Collection *collection, int granularityMinutes, QObject *parent)
+    : QObject(parent), m_collection(collection), m_granularity(qBound(1, granularityMinutes, 24 * 60)),
+      m_zone(QTimeZone::systemTimeZone())
+{
+    connect(m_collection, &Collection::calendarsChanged, this, &FreeBusy::syncCalendars);
+    syncCalendars();
+}
+
+void FreeBusy::setTimeZone(const QTimeZone &zone)
+{
+    if (zone == m_zone) return;
+    m_zone = zone;
+    invalidate();
+}
+
+void FreeBusy::invalidate()
+{
+    m_days.clear();
+    m_reach.clear();
+}
+
+void FreeBusy::syncCalendars()
+{
+    const QList<Cal*> calendars = m_collection->calendars();
+    const QList<Cal*> previous = std::exchange(m_attached, {});
+    for (Cal *cal : previous) {
+        if (!calendars.contains(cal)) disconnect(cal, nullptr, this, nullptr);
+    }
+    for (Cal *cal : calendars) {
+        if (previous.contains(cal)) {
+            m_attached.append(cal);
+        } else {
+            attach(cal);
+        }
+    }
+    invalidate();
+    qDebug() << "FreeBusy: Tracking" << m_attached.size() << "calendars of" << m_collection->id();
+}
+
+void FreeBusy::attach(Cal *cal)
+{
+    m_attached.append(cal);
+    connect(cal, &QAbstractItemModel::rowsInserted, this, [this, cal](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; ++row) itemChanged(*cal->itemAt(row));
+    });
+    connect(cal, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this, cal](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; ++row) itemChanged(*cal->itemAt(row));
+    });
+    connect(cal, &QAbstractItemModel::dataChanged, this,
+            [this, cal](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+                if (!roles.isEmpty() && !roles.contains(Cal::SortRole)) return; // Flags only; times are unchanged
+                for (int row = topLeft.row(); row <= bottomRight.row(); ++row) itemChanged(*cal->itemAt(row));
+            });
+    connect(cal, &QAbstractItemModel::modelReset, this, &FreeBusy::invalidate);
+    connect(cal, &QObject::destroyed, this, [this](QObject *object) {
+        m_attached.removeOne(static_cast<Cal*>(object));
+        invalidate();
+    });
+}
+
+void FreeBusy::itemChanged(const CalendarItem &item) const
+{
+    // Days the item blocked when they were filled, and days it may block now
+    const auto old = m_reach.constFind(item.handle());
+    if (old != m_reach.constEnd()) {
+        invalidateDays(old.value());
+        m_reach.erase(old);
+    }
+    Reach reach;
+    if (reachOf(item, &reach)) invalidateDays(reach);
+}
+
+bool FreeBusy::reachOf(const CalendarItem &item, Reach *reach) const
+{
+    if (!dynamic_cast<const Event*>(&item) || item.isTransparent()) return false;
+    const QDateTime start = item.dtStart();
+    const QDateTime end = item.dtEndOrDue();
+    if (!start.isValid()) return false;
+    if (item.allDay()) {
+        reach->first = start.date(); // Floating dates, the same day in every zone
+        reach->last = end.isValid() && end.date() > start.date() ? end.date() : start.date();
+    } else {
+        reach->first = start.toTimeZone(m_zone).date();
+        reach->last = end.isValid() && end > start ? end.addMSecs(-1).toTimeZone(m_zone).date() : reach->first;
+    }
+    if (item.recurs()) {
+        reach->last = QDate(); // Instances continue past the first; the rule's end is not worth loading for
+    }
+    const QDateTime recurrenceId = item.recurrenceId();
+    if (recurrenceId.isValid()) {
+        // An override also frees the instance it replaces
+        const QDate replaced = item.allDay() ? recurrenceId.date() : recurrenceId.toTimeZone(m_zone).date();
+        if (replaced < reach->first) reach->first = replaced;
+        if (reach->last.isValid() && replaced > reach->last) reach->last = replaced;
+    }
+    return true;
+}
+
+void FreeBusy::invalidateDays(const Reach &reach) const
+{
+    auto it = m_days.lowerBound(reach.first);
+    while (it != m_days.end() && (!reach.last.isValid() || it.key() <= reach.last)) {
+        it = m_days.erase(it);
+    }
+}
+
+void FreeBusy::catchUp() const
+{
+    // Items edited in place since the last query: any revision above the last check
+    const quint64 latest = CalendarItem::latestRevision();
+    if (latest == m_checkedRevision) return;
+    if (!m_days.isEmpty()) {
+        for (Cal *cal : m_attached) {
+            const QList<QSharedPointer<CalendarItem>> items = cal->items();
+            for (const QSharedPointer<CalendarItem> &item : items) {
+                if (item->revision() > m_checkedRevision) itemChanged(*item);
+            }
+        }
+    }
+    m_checkedRevision = latest;
+}
+
+QBitArray FreeBusy::fillDay(const QDate &date) const
+{
+    const QDateTime dayStart = date.startOfDay(m_zone);
+    const QDateTime dayEnd = date.addDays(1).startOfDay(m_zone);
+    const qint64 dayMsecs = dayStart.msecsTo(dayEnd); // 23 or 25 hours across a DST change
+    const qint64 slotMsecs = qint64(m_granularity) * 60 * 1000;
+    QBitArray bits(int((dayMsecs + slotMsecs - 1) / slotMsecs));
+
+    for (Cal *cal : m_attached) {
+        const QList<OccurrenceCache::Occurrence> occurrences = cal->occurrencesInRange(dayStart, dayEnd);
+        for (const OccurrenceCache::Occurrence &occurrence : occurrences) {
+            const CalendarItem &item = *occurrence.item;
+            Reach reach;
+            if (!reachOf(item, &reach)) continue;
+            m_reach.insert(item.handle(), reach);
+            if (item.allDay()) {
+                const QDate last = occurrence.end.isValid() ? occurrence.end.date() : occurrence.start.date();
+                if (occurrence.start.date() <= date && date <= last) bits.fill(true);
+                continue;
+            }
+            if (!occurrence.end.isValid()) continue; // Instants take no time
+            const qint64 from = qMax(dayStart.msecsTo(occurrence.start), qint64(0));
+            const qint64 to = qMin(dayStart.msecsTo(occurrence.end), dayMsecs);
+            if (to <= from) continue;
+            bits.fill(true, int(from / slotMsecs), int((to + slotMsecs - 1) / slotMsecs));
+        }
+    }
+    ++m_filled;
+    return bits;
+}
+
+QBitArray FreeBusy::busySlots(const QDate &date) const
+{
+    catchUp();
+    auto it = m_days.constFind(date);
+    if (it == m_days.constEnd()) {
+        it = m_days.insert(date, fillDay(date));
+    }
+    return it.value();
+}
+
+QList<FreeBusy::Interval> FreeBusy::busy(const QDateTime &from, const QDateTime &to) const
+{
+    QList<Interval> intervals;
+    if (!from.isValid() || !to.isValid() || from >= to) return intervals;
+    const qint64 slotMsecs = qint64(m_granularity) * 60 * 1000;
+    const QDate lastDay = to.addMSecs(-1).toTimeZone(m_zone).date();
+    for (QDate date = from.toTimeZone(m_zone).date(); date <= lastDay; date = date.addDays(1)) {
+        const QBitArray bits = busySlots(date);
+        const QDateTime dayStart = date.startOfDay(m_zone);
+        const QDateTime dayEnd = date.addDays(1).startOfDay(m_zone);
+        for (int slot = 0; slot < bits.size();) {
+            if (!bits.testBit(slot)) {
+                ++slot;
+                continue;
+            }
+            int endSlot = slot + 1;
+            while (endSlot < bits.size() && bits.testBit(endSlot)) ++endSlot;
+            const QDateTime start = qMax(dayStart.addMSecs(slot * slotMsecs), from);
+            const QDateTime end = qMin(qMin(dayStart.addMSecs(endSlot * slotMsecs), dayEnd), to);
+            if (start < end) {
+                if (!intervals.isEmpty() && intervals.last().end >= start) {
+                    intervals.last().end = end; // Continues over midnight
+                } else {
+                    intervals.append({start, end});
+                }
+            }
+            slot = endSlot;
+        }
+    }
+    return intervals;
+}
+
+QList<FreeBusy::Interval> FreeBusy::free(const QDateTime &from, const QDateTime &to) const
+{
+    QList<Interval> intervals;
+    QDateTime cursor = from;
+    for (const Interval &interval : busy(from, to)) {
+        if (cursor < interval.start) intervals.append({cursor, interval.start});
+        cursor = interval.end;
+    }
+    if (from.isValid() && cursor < to) intervals.append({cursor, to});
+    return intervals;
+}
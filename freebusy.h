@@ -0,0 +1,74 @@
+#ifndef FREEBUSY_H
+#define FREEBUSY_H
+
+#include <QObject>
+#include <QBitArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QTimeZone>
+#include "idtable.h"
+
+class Cal;
+class CalendarItem;
+class Collection;
+
+// Busy time across every calendar of a Collection, kept per day as one bit per slot of granularity
+// minutes from midnight in the engine's time zone. A day is filled on its first query from each calendar's
+// occurrencesInRange(), so recurrences, EXDATEs and overrides count as they do in the views. All-day events
+// block their whole days; transparent events (TRANSP:TRANSPARENT) and to-dos never block.
+// A changed item refills only the cached days it covered before or after the change: changes reported by
+// the calendars' model signals, and in-place edits caught up by revision on the next query.
+class FreeBusy : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Interval {
+        QDateTime start;
+        QDateTime end; // Exclusive
+    };
+
+    explicit FreeBusy(Collection *collection, int granularityMinutes = 1, QObject *parent = nullptr);
+
+    int granularity() const { return m_granularity; }
+    QTimeZone timeZone() const { return m_zone; }
+    void setTimeZone(const QTimeZone &zone); // Moves the day boundaries, so the cache is dropped
+
+    // One bit per slot; the last slot of a day that is not a multiple of the granularity is short
+    QBitArray busySlots(const QDate &date) const;
+    // Busy and free time within [from, to), adjacent slots and days merged into one interval
+    QList<Interval> busy(const QDateTime &from, const QDateTime &to) const;
+    QList<Interval> free(const QDateTime &from, const QDateTime &to) const;
+
+    void invalidate(); // Drops every cached day
+    int cachedDays() const { return m_days.size(); }
+    int filledDays() const { return m_filled; } // Days computed so far, refills included
+
+private:
+    // Dates an item may block; an invalid last date means open-ended (an unbounded series)
+    struct Reach {
+        QDate first;
+        QDate last;
+    };
+
+    void syncCalendars();
+    void attach(Cal *cal);
+    void itemChanged(const CalendarItem &item) const;
+    bool reachOf(const CalendarItem &item, Reach *reach) const; // False if the item never blocks time
+    void invalidateDays(const Reach &reach) const;
+    void catchUp() const;
+    QBitArray fillDay(const QDate &date) const;
+
+    Collection *m_collection;
+    int m_granularity;
+    QTimeZone m_zone;
+    QList<Cal*> m_attached;
+    mutable QMap<QDate, QBitArray> m_days; // Ordered, so a reach drops its days as one range
+    mutable QHash<IdTable::Id, Reach> m_reach; // Items met while filling cached days -> days they blocked
+    mutable quint64 m_checkedRevision = 0; // CalendarItem::latestRevision() at the last catch-up
+    mutable int m_filled = 0;
+};
+
+#endif // FREEBUSY_H
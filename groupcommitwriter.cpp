@@ -0,0 +1,186 @@
+#include "groupcommitwriter.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QDebug>
+#include <cstdio>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool syncFile(const QString &path)
+{
+#ifdef Q_OS_UNIX
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    Q_UNUSED(path);
+    return true; // No portable fsync through QFile; atomicity still comes from the rename
+#endif
+}
+
+bool syncDirectory(const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    Q_UNUSED(dirPath);
+    return true; // Renames are journaled with the directory on the platforms we ship to
+#endif
+}
+
+bool replaceFile(const QString &tempPath, const QString &filePath)
+{
+#ifdef Q_OS_UNIX
+    // rename(2) replaces the target atomically; QFile::rename refuses to overwrite
+    return std::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(filePath).constData()) == 0;
+#else
+    QFile::remove(filePath);
+    return QFile::rename(tempPath, filePath);
+#endif
+}
+
+} // namespace
+
+GroupCommitWriter::GroupCommitWriter(Durability durability)
+    : m_durability(durability)
+{
+}
+
+GroupCommitWriter::~GroupCommitWriter()
+{
+    discard();
+}
+
+int GroupCommitWriter::pendingCount() const
+{
+    QMutexLocker locker(&m_pendingMutex);
+    return m_pending.size();
+}
+
+QString GroupCommitWriter::tempPathFor(const QString &filePath)
+{
+    // Hidden and without the .ics suffix, so directory scans never pick it up
+    const QFileInfo info(filePath);
+    return info.dir().filePath("." + info.fileName() + ".tmp");
+}
+
+bool GroupCommitWriter::stage(const QString &filePath, const QByteArray &data, QString *error)
+{
+    const QString tempPath = tempPathFor(filePath);
+    QFile file(tempPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = file.errorString();
+        qWarning() << "GroupCommitWriter: Failed to open" << tempPath << ":" << file.errorString();
+        return false;
+    }
+    if (file.write(data) != data.size() || !file.flush()) {
+        if (error) *error = file.errorString();
+        qWarning() << "GroupCommitWriter: Write failed for" << tempPath << ":" << file.errorString();
+        file.close();
+        QFile::remove(tempPath);
+        return false;
+    }
+    file.close();
+
+    QMutexLocker locker(&m_pendingMutex);
+    for (const Pending &pending : std::as_const(m_pending)) {
+        if (pending.filePath == filePath) {
+            return true; // Staged twice in one group; the temp file now holds the latest bytes
+        }
+    }
+    m_pending.append({filePath, tempPath});
+    return true;
+}
+
+GroupCommitWriter::Result GroupCommitWriter::commit()
+{
+    Result result;
+    auto fail = [&result](const Pending &pending, const QString &reason) {
+        qWarning() << "GroupCommitWriter:" << reason << pending.filePath;
+        QFile::remove(pending.tempPath);
+        ++result.failed;
+        result.failedPaths.append(pending.filePath);
+        if (result.errorString.isEmpty()) {
+            result.errorString = reason + " " + pending.filePath;
+        }
+    };
+
+    auto syncFailed = [&result](const QString &dirPath) {
+        // The renames already happened, so the files count as written, just not yet durable
+        qWarning() << "GroupCommitWriter: Failed to sync directory" << dirPath;
+        if (result.errorString.isEmpty()) {
+            result.errorString = "Failed to sync directory " + dirPath;
+        }
+    };
+
+    // Phase 1: data of every temp file reaches the disk before any target is replaced
+    QList<Pending> durable;
+    durable.reserve(m_pending.size());
+    for (const Pending &pending : std::as_const(m_pending)) {
+        if (m_durability == Durability::GroupSync) {
+            ++result.fileSyncs;
+            if (!syncFile(pending.tempPath)) {
+                fail(pending, "Failed to sync");
+                continue;
+            }
+        }
+        durable.append(pending);
+    }
+
+    // Phase 2: atomic replace, then one directory flush per directory makes the renames durable.
+    // ItemSync instead flushes the file, renames and flushes its directory one item at a time.
+    QSet<QString> directories;
+    for (const Pending &pending : std::as_const(durable)) {
+        if (m_durability == Durability::ItemSync) {
+            ++result.fileSyncs;
+            if (!syncFile(pending.tempPath)) {
+                fail(pending, "Failed to sync");
+                continue;
+            }
+        }
+        if (!replaceFile(pending.tempPath, pending.filePath)) {
+            fail(pending, "Failed to rename into place");
+            continue;
+        }
+        const QString dirPath = QFileInfo(pending.filePath).absolutePath();
+        if (m_durability == Durability::ItemSync) {
+            ++result.directorySyncs;
+            if (!syncDirectory(dirPath)) syncFailed(dirPath);
+        } else {
+            directories.insert(dirPath);
+        }
+        ++result.written;
+        result.writtenPaths.append(pending.filePath);
+    }
+    if (m_durability == Durability::GroupSync) {
+        for (const QString &dirPath : std::as_const(directories)) {
+            ++result.directorySyncs;
+            if (!syncDirectory(dirPath)) syncFailed(dirPath);
+        }
+    }
+
+    m_pending.clear();
+    qDebug() << "GroupCommitWriter: Committed" << result.written << "files," << result.failed << "failed,"
+             << result.fileSyncs << "file syncs," << result.directorySyncs << "directory syncs";
+    return result;
+}
+
+void GroupCommitWriter::discard()
+{
+    for (const Pending &pending : std::as_const(m_pending)) {
+        QFile::remove(pending.tempPath);
+    }
+    m_pending.clear();
+}
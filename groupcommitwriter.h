@@ -0,0 +1,56 @@
+#ifndef GROUPCOMMITWRITER_H
+#define GROUPCOMMITWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+
+// Writes a set of files so that each one is either fully old or fully new after a crash.
+// stage() writes the bytes to a hidden temp file next to the target; commit() flushes all temp
+// files, renames them over their targets and then flushes each touched directory once.
+class GroupCommitWriter
+{
+public:
+    enum class Durability {
+        None,      // Atomic rename only; data may still be in the page cache after commit()
+        GroupSync, // fsync every temp file, rename, then fsync each directory once per commit
+        ItemSync   // fsync file and directory around every single rename (the slow baseline)
+    };
+
+    struct Result {
+        int written = 0;
+        int failed = 0;
+        int fileSyncs = 0;
+        int directorySyncs = 0;
+        QStringList writtenPaths;
+        QStringList failedPaths;
+        QString errorString; // First error seen
+    };
+
+    explicit GroupCommitWriter(Durability durability = Durability::GroupSync);
+    ~GroupCommitWriter(); // Uncommitted temp files are removed
+
+    Durability durability() const { return m_durability; }
+    int pendingCount() const;
+
+    // Safe to call from several threads at once for distinct paths; commit() and discard() must not overlap it
+    bool stage(const QString &filePath, const QByteArray &data, QString *error = nullptr);
+    Result commit();
+    void discard();
+
+    static QString tempPathFor(const QString &filePath);
+
+private:
+    struct Pending {
+        QString filePath;
+        QString tempPath;
+    };
+
+    Durability m_durability;
+    mutable QMutex m_pendingMutex; // Guards m_pending while workers stage in parallel
+    QList<Pending> m_pending;
+};
+
+#endif // GROUPCOMMITWRITER_H
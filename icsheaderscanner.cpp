@@ -0,0 +1,385 @@
+#include "icsheaderscanner.h"
+#include <QTimeZone>
+
+namespace {
+
+// One logical content line (RFC 5545 §3.1): the first physical line plus any continuation lines
+struct ContentLine {
+    QByteArrayView first; // First physical line, terminator stripped
+    qsizetype end = 0;    // Offset just past the last continuation line
+    bool folded = false;
+};
+
+struct Property {
+    QByteArrayView name;
+    QByteArrayView params; // Raw ";KEY=VALUE..." text between the name and the colon
+    QByteArrayView value;
+};
+
+qsizetype physicalLineEnd(QByteArrayView data, qsizetype pos, qsizetype *next)
+{
+    qsizetype newline = data.indexOf('\n', pos);
+    if (newline < 0) {
+        newline = data.size();
+        *next = data.size();
+    } else {
+        *next = newline + 1;
+    }
+    if (newline > pos && data[newline - 1] == '\r') {
+        --newline;
+    }
+    return newline;
+}
+
+ContentLine readLine(QByteArrayView data, qsizetype pos)
+{
+    ContentLine line;
+    qsizetype next = 0;
+    line.first = data.sliced(pos, physicalLineEnd(data, pos, &next) - pos);
+    while (next < data.size() && (data[next] == ' ' || data[next] == '\t')) {
+        line.folded = true;
+        physicalLineEnd(data, next, &next);
+    }
+    line.end = next;
+    return line;
+}
+
+// Joins a folded line; the only allocation on the scan path, and only for fields we keep
+QByteArray unfold(QByteArrayView data, qsizetype pos, qsizetype end)
+{
+    QByteArray out;
+    out.reserve(end - pos);
+    bool lineStart = false;
+    for (qsizetype i = pos; i < end; ++i) {
+        const char c = data[i];
+        if (c == '\r') continue;
+        if (c == '\n') {
+            lineStart = true;
+            continue;
+        }
+        if (lineStart) {
+            lineStart = false;
+            if (c == ' ' || c == '\t') continue;
+        }
+        out.append(c);
+    }
+    return out;
+}
+
+bool splitProperty(QByteArrayView line, Property *prop)
+{
+    qsizetype nameEnd = 0;
+    while (nameEnd < line.size() && line[nameEnd] != ';' && line[nameEnd] != ':') {
+        ++nameEnd;
+    }
+    if (nameEnd == line.size()) return false;
+
+    qsizetype colon = nameEnd;
+    bool quoted = false;
+    for (; colon < line.size(); ++colon) {
+        if (line[colon] == '"') {
+            quoted = !quoted;
+        } else if (line[colon] == ':' && !quoted) {
+            break;
+        }
+    }
+    if (colon == line.size()) return false;
+
+    prop->name = line.first(nameEnd);
+    prop->params = line.sliced(nameEnd, colon - nameEnd);
+    prop->value = line.sliced(colon + 1);
+    return true;
+}
+
+bool is(QByteArrayView text, QByteArrayView expected)
+{
+    return text.compare(expected, Qt::CaseInsensitive) == 0;
+}
+
+QByteArrayView paramValue(QByteArrayView params, QByteArrayView key)
+{
+    qsizetype pos = 0;
+    while (pos < params.size()) {
+        // Each parameter starts after a ';' that is not inside a quoted value
+        qsizetype end = pos + 1;
+        bool quoted = false;
+        for (; end < params.size(); ++end) {
+            if (params[end] == '"') {
+                quoted = !quoted;
+            } else if (params[end] == ';' && !quoted) {
+                break;
+            }
+        }
+        const QByteArrayView param = params.sliced(pos + 1, end - pos - 1);
+        const qsizetype equals = param.indexOf('=');
+        if (equals > 0 && is(param.first(equals), key)) {
+            QByteArrayView value = param.sliced(equals + 1);
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.sliced(1, value.size() - 2);
+            }
+            return value;
+        }
+        pos = end;
+    }
+    return QByteArrayView();
+}
+
+int number(QByteArrayView text, qsizetype pos, int count, bool *ok)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const char c = text[pos + i];
+        if (c < '0' || c > '9') {
+            *ok = false;
+            return 0;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+// DATE or DATE-TIME in UTC, floating or TZID form
+bool parseDateTime(QByteArrayView value, QByteArrayView params, QDateTime *out, bool *isDate)
+{
+    value = value.trimmed();
+    if (value.size() < 8) return false;
+    bool ok = true;
+    const QDate date(number(value, 0, 4, &ok), number(value, 4, 2, &ok), number(value, 6, 2, &ok));
+    if (!ok || !date.isValid()) return false;
+
+    if (value.size() == 8) {
+        *isDate = true;
+        *out = QDateTime(date, QTime(0, 0));
+        return true;
+    }
+    if (value.size() < 15 || (value[8] != 'T' && value[8] != 't')) return false;
+    const QTime time(number(value, 9, 2, &ok), number(value, 11, 2, &ok), number(value, 13, 2, &ok));
+    if (!ok || !time.isValid()) return false;
+    *isDate = false;
+
+    if (value.size() == 16 && (value[15] == 'Z' || value[15] == 'z')) {
+        *out = QDateTime(date, time, QTimeZone::UTC);
+        return true;
+    }
+    if (value.size() != 15) return false;
+
+    const QByteArrayView tzid = paramValue(params, "TZID");
+    if (tzid.isEmpty()) {
+        *out = QDateTime(date, time); // Floating time is read as local time, as KCalendarCore does
+        return true;
+    }
+    const QTimeZone zone(tzid.toByteArray());
+    if (!zone.isValid()) return false; // Custom VTIMEZONE; only the full parser can resolve it
+    *out = QDateTime(date, time, zone);
+    return true;
+}
+
+// RFC 5545 §3.3.6; day-based parts are kept apart so they follow calendar days across DST
+bool parseDuration(QByteArrayView value, qint64 *days, qint64 *seconds)
+{
+    value = value.trimmed();
+    qsizetype pos = 0;
+    int sign = 1;
+    if (pos < value.size() && (value[pos] == '+' || value[pos] == '-')) {
+        sign = value[pos] == '-' ? -1 : 1;
+        ++pos;
+    }
+    if (pos >= value.size() || (value[pos] != 'P' && value[pos] != 'p')) return false;
+    ++pos;
+
+    *days = 0;
+    *seconds = 0;
+    bool inTime = false;
+    while (pos < value.size()) {
+        if (value[pos] == 'T' || value[pos] == 't') {
+            inTime = true;
+            ++pos;
+            continue;
+        }
+        qint64 amount = 0;
+        const qsizetype digitsStart = pos;
+        while (pos < value.size() && value[pos] >= '0' && value[pos] <= '9') {
+            amount = amount * 10 + (value[pos] - '0');
+            ++pos;
+        }
+        if (pos == digitsStart || pos >= value.size()) return false;
+        switch (value[pos]) {
+        case 'W': case 'w': if (inTime) return false; *days += amount * 7; break;
+        case 'D': case 'd': if (inTime) return false; *days += amount; break;
+        case 'H': case 'h': if (!inTime) return false; *seconds += amount * 3600; break;
+        case 'M': case 'm': if (!inTime) return false; *seconds += amount * 60; break;
+        case 'S': case 's': if (!inTime) return false; *seconds += amount; break;
+        default: return false;
+        }
+        ++pos;
+    }
+    *days *= sign;
+    *seconds *= sign;
+    return true;
+}
+
+QString unescapeText(QByteArrayView value)
+{
+    if (!value.contains('\\')) {
+        return QString::fromUtf8(value);
+    }
+    QByteArray out;
+    out.reserve(value.size());
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            const char next = value[++i];
+            out.append(next == 'n' || next == 'N' ? '\n' : next);
+        } else {
+            out.append(value[i]);
+        }
+    }
+    return QString::fromUtf8(out);
+}
+
+void appendCategories(QByteArrayView value, QStringList *categories)
+{
+    qsizetype start = 0;
+    for (qsizetype i = 0; i <= value.size(); ++i) {
+        if (i < value.size() && value[i] == '\\') {
+            ++i; // Escaped character, including "\,"
+        } else if (i == value.size() || value[i] == ',') {
+            if (i > start) {
+                categories->append(unescapeText(value.sliced(start, i - start)));
+            }
+            start = i + 1;
+        }
+    }
+}
+
+bool isIndexedProperty(QByteArrayView name)
+{
+    return is(name, "UID") || is(name, "SUMMARY") || is(name, "DTSTART") || is(name, "DTEND")
+           || is(name, "DUE") || is(name, "DURATION") || is(name, "RRULE") || is(name, "CATEGORIES")
+           || is(name, "LAST-MODIFIED") || is(name, "RECURRENCE-ID") || is(name, "RELATED-TO")
+           || is(name, "PERCENT-COMPLETE") || is(name, "COMPLETED") || is(name, "STATUS")
+           || is(name, "TRANSP");
+}
+
+} // namespace
+
+bool IcsHeaderScanner::scan(QByteArrayView data, Header *header)
+{
+    *header = Header();
+    int level = 0;      // Open components, VCALENDAR included
+    int itemLevel = -1; // Level of the VEVENT/VTODO, -1 until it opens
+    bool itemClosed = false;
+    bool startIsDate = false;
+    bool endIsDate = false;
+    bool dueIsDate = false;
+    bool hasEnd = false;
+    bool hasDuration = false;
+    qint64 durationDays = 0;
+    qint64 durationSeconds = 0;
+    bool completed = false;
+
+    qsizetype pos = data.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+    while (pos < data.size()) {
+        const qsizetype lineStart = pos;
+        const ContentLine line = readLine(data, pos);
+        pos = line.end;
+
+        Property prop;
+        QByteArray unfolded;
+        if (!splitProperty(line.first, &prop)) {
+            if (!line.folded) continue;
+            unfolded = unfold(data, lineStart, line.end);
+            if (!splitProperty(unfolded, &prop)) continue;
+        }
+
+        if (is(prop.name, "BEGIN")) {
+            ++level;
+            const QByteArrayView component = prop.value.trimmed();
+            if (is(component, "VEVENT") || is(component, "VTODO")) {
+                if (itemLevel != -1) {
+                    return false; // Several items (e.g. RECURRENCE-ID overrides); the full parser decides
+                }
+                header->type = is(component, "VEVENT") ? Type::Event : Type::Todo;
+                itemLevel = level;
+            }
+            continue;
+        }
+        if (is(prop.name, "END")) {
+            if (level == itemLevel) {
+                itemClosed = true;
+            }
+            --level;
+            continue;
+        }
+        if (itemClosed || level != itemLevel || !isIndexedProperty(prop.name)) {
+            continue; // Calendar-level, VTIMEZONE and VALARM properties, or fields we do not index
+        }
+        if (line.folded && unfolded.isEmpty()) {
+            unfolded = unfold(data, lineStart, line.end);
+            splitProperty(unfolded, &prop);
+        }
+
+        if (is(prop.name, "UID")) {
+            header->uid = unescapeText(prop.value);
+        } else if (is(prop.name, "SUMMARY")) {
+            header->summary = unescapeText(prop.value);
+        } else if (is(prop.name, "DTSTART")) {
+            if (!parseDateTime(prop.value, prop.params, &header->dtStart, &startIsDate)) return false;
+        } else if (is(prop.name, "DTEND")) {
+            if (!parseDateTime(prop.value, prop.params, &header->dtEnd, &endIsDate)) return false;
+            hasEnd = true;
+        } else if (is(prop.name, "DUE")) {
+            if (!parseDateTime(prop.value, prop.params, &header->due, &dueIsDate)) return false;
+        } else if (is(prop.name, "DURATION")) {
+            if (!parseDuration(prop.value, &durationDays, &durationSeconds)) return false;
+            hasDuration = true;
+        } else if (is(prop.name, "RRULE")) {
+            header->rrule = QString::fromLatin1(prop.value);
+        } else if (is(prop.name, "CATEGORIES")) {
+            appendCategories(prop.value, &header->categories);
+        } else if (is(prop.name, "RECURRENCE-ID")) {
+            return false; // Overrides are keyed by UID plus RECURRENCE-ID; the full parser builds that id
+        } else if (is(prop.name, "RELATED-TO")) {
+            const QByteArrayView relType = paramValue(prop.params, "RELTYPE");
+            if (relType.isEmpty() || is(relType, "PARENT")) {
+                header->relatedTo = unescapeText(prop.value);
+            }
+        } else if (is(prop.name, "PERCENT-COMPLETE")) {
+            header->percentComplete = qBound(0, prop.value.trimmed().toByteArray().toInt(), 100);
+        } else if (is(prop.name, "COMPLETED")) {
+            completed = true;
+        } else if (is(prop.name, "STATUS")) {
+            completed = completed || is(prop.value.trimmed(), "COMPLETED");
+        } else if (is(prop.name, "TRANSP")) {
+            header->transparent = is(prop.value.trimmed(), "TRANSPARENT");
+        } else if (is(prop.name, "LAST-MODIFIED")) {
+            bool ignored = false;
+            if (!parseDateTime(prop.value, prop.params, &header->lastModified, &ignored)) return false;
+        }
+    }
+
+    if (!itemClosed) {
+        return false; // No item, or the file is truncated inside it
+    }
+
+    // Mirror what KCalendarCore::Event/Todo report, so lazily indexed items look the same as parsed ones
+    if (header->type == Type::Event) {
+        header->percentComplete = 0; // Only to-dos carry progress
+        header->allDay = header->dtStart.isValid() && startIsDate;
+        if (hasEnd) {
+            if (header->allDay && endIsDate) {
+                header->dtEnd = header->dtEnd.addDays(-1); // iCalendar's exclusive end date becomes inclusive
+            }
+        } else if (hasDuration) {
+            if (header->allDay) return false; // Day-count semantics for all-day durations are left to the parser
+            header->dtEnd = header->dtStart.addDays(durationDays).addSecs(durationSeconds);
+        } else {
+            header->dtEnd = header->dtStart;
+        }
+    } else {
+        header->transparent = false; // Only events take part in free/busy
+        header->allDay = (header->dtStart.isValid() && startIsDate) || (header->due.isValid() && dueIsDate);
+        if (hasDuration && !header->due.isValid()) return false; // DTSTART+DURATION to-dos go through the parser
+        if (completed) header->percentComplete = 100;
+    }
+    return header->isValid();
+}
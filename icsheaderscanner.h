@@ -0,0 +1,43 @@
+#ifndef ICSHEADERSCANNER_H
+#define ICSHEADERSCANNER_H
+
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+
+// Pulls the indexing fields of the first VEVENT/VTODO straight out of raw .ics bytes.
+// Walks the buffer in place; only the values it returns are allocated. Anything it cannot
+// represent faithfully (unknown TZID, unsupported component) makes scan() fail so callers
+// fall back to KCalendarCore.
+class IcsHeaderScanner
+{
+public:
+    enum class Type {
+        Unknown,
+        Event,
+        Todo
+    };
+
+    struct Header {
+        Type type = Type::Unknown;
+        QString uid;
+        QString summary;
+        QDateTime dtStart;
+        QDateTime dtEnd; // Inclusive, as KCalendarCore reports it; derived from DURATION when DTEND is absent
+        QDateTime due;
+        bool allDay = false;
+        QString rrule;
+        QStringList categories;
+        QDateTime lastModified;
+        QString relatedTo;       // Parent UID (RELATED-TO without RELTYPE or with RELTYPE=PARENT)
+        int percentComplete = 0; // To-dos only; 100 once completed, as KCalendarCore::Todo::isCompleted() sees it
+        bool transparent = false; // Events only: TRANSP:TRANSPARENT, which does not block time
+
+        bool isValid() const { return type != Type::Unknown && !uid.isEmpty(); }
+    };
+
+    static bool scan(QByteArrayView data, Header *header);
+};
+
+#endif // ICSHEADERSCANNER_H
@@ -0,0 +1,93 @@
+#include "icsstreamreader.h"
+#include <QIODevice>
+#include <QDebug>
+
+namespace {
+
+// "BEGIN:NAME" / "END:NAME" with the name returned; these lines are never folded in practice
+bool componentLine(const QByteArray &line, const char *keyword, QByteArray *name)
+{
+    const qsizetype keywordLength = qstrlen(keyword);
+    if (line.size() <= keywordLength || qstrnicmp(line.constData(), keyword, keywordLength) != 0) {
+        return false;
+    }
+    *name = line.mid(keywordLength).trimmed().toUpper();
+    return true;
+}
+
+} // namespace
+
+IcsStreamReader::IcsStreamReader(QIODevice *device)
+    : m_device(device)
+{
+}
+
+bool IcsStreamReader::readNext(QByteArray *calendarData)
+{
+    QByteArray component; // Raw text of the component being read
+    QByteArray componentName;
+    bool skipping = false;
+
+    while (!m_device->atEnd()) {
+        const QByteArray line = m_device->readLine();
+        m_bytesRead += line.size();
+        QByteArray name;
+
+        if (m_depth == 0) {
+            if (componentLine(line, "BEGIN:", &name) && name == "VCALENDAR") {
+                m_depth = 1; // Concatenated VCALENDARs are read one after another
+            }
+            continue;
+        }
+
+        if (m_depth == 1) {
+            if (componentLine(line, "END:", &name) && name == "VCALENDAR") {
+                m_depth = 0;
+            } else if (componentLine(line, "BEGIN:", &name)) {
+                componentName = name;
+                component = line;
+                skipping = false;
+                m_depth = 2;
+            } else if (m_componentsRead == 0) {
+                m_prolog += line; // Calendar properties precede the first component
+            }
+            continue;
+        }
+
+        if (!skipping) {
+            component += line;
+            if (component.size() > m_maxComponentSize) {
+                qWarning() << "IcsStreamReader: Skipping" << componentName << "larger than" << m_maxComponentSize << "bytes";
+                component.clear();
+                skipping = true;
+            }
+        }
+        if (componentLine(line, "BEGIN:", &name)) {
+            ++m_depth;
+        } else if (componentLine(line, "END:", &name) && --m_depth == 1) {
+            if (skipping) {
+                ++m_componentsSkipped;
+                continue;
+            }
+            if (componentName == "VTIMEZONE") {
+                m_timezones += component;
+                continue;
+            }
+            if (componentName != "VEVENT" && componentName != "VTODO" && componentName != "VJOURNAL") {
+                ++m_componentsSkipped; // VFREEBUSY, X- components
+                continue;
+            }
+
+            ++m_componentsRead;
+            calendarData->clear();
+            calendarData->reserve(m_prolog.size() + m_timezones.size() + component.size() + 40);
+            *calendarData += "BEGIN:VCALENDAR\r\n";
+            *calendarData += m_prolog;
+            *calendarData += m_timezones;
+            *calendarData += component;
+            *calendarData += "END:VCALENDAR\r\n";
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#ifndef ICSSTREAMREADER_H
+#define ICSSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+// Splits a VCALENDAR stream into one self-contained VCALENDAR per VEVENT/VTODO/VJOURNAL.
+// Reads line by line, so memory is bounded by the largest single component rather than the file.
+// Calendar properties and VTIMEZONEs seen so far are repeated in every piece so each parses on its own.
+class IcsStreamReader
+{
+public:
+    explicit IcsStreamReader(QIODevice *device);
+
+    // Next item wrapped as its own VCALENDAR; false once the stream is exhausted
+    bool readNext(QByteArray *calendarData);
+
+    int componentsRead() const { return m_componentsRead; }
+    int componentsSkipped() const { return m_componentsSkipped; }
+    qint64 bytesRead() const { return m_bytesRead; }
+
+    // Larger components are skipped instead of buffered
+    void setMaxComponentSize(qint64 bytes) { m_maxComponentSize = bytes; }
+
+private:
+    QIODevice *m_device;
+    QByteArray m_prolog;    // VCALENDAR-level properties (VERSION, PRODID, ...)
+    QByteArray m_timezones; // Complete VTIMEZONE components
+    int m_depth = 0;        // 0 outside VCALENDAR, 1 at calendar level, 2+ inside a component
+    qint64 m_maxComponentSize = 16 * 1024 * 1024;
+    qint64 m_bytesRead = 0;
+    int m_componentsRead = 0;
+    int m_componentsSkipped = 0;
+};
+
+#endif // ICSSTREAMREADER_H
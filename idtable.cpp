@@ -0,0 +1,141 @@
+#include "idtable.h"
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <utility>
+
+namespace {
+
+struct Entry {
+    QString text;
+    IdTable::Id parent = 0;
+};
+
+struct Table {
+    QReadWriteLock lock;
+    QList<Entry> entries{Entry()}; // Slot 0 is the null handle
+    QHash<std::pair<IdTable::Id, QString>, IdTable::Id> byKey; // (parent, text) -> handle
+    QHash<QString, IdTable::Id> calendars; // Calendar ids are unique across collections
+    QHash<QString, IdTable::Id> collections; // Lets an unregistered calendar id find its collection prefix
+};
+
+Table &table()
+{
+    static Table instance;
+    return instance;
+}
+
+IdTable::Id lookup(Table &t, IdTable::Id parent, const QString &text)
+{
+    QReadLocker locker(&t.lock);
+    return t.byKey.value({parent, text}, 0);
+}
+
+IdTable::Id insert(Table &t, IdTable::Id parent, const QString &text)
+{
+    QWriteLocker locker(&t.lock);
+    const std::pair<IdTable::Id, QString> key(parent, text);
+    if (const IdTable::Id existing = t.byKey.value(key, 0)) {
+        return existing; // Another thread won the race
+    }
+    const IdTable::Id id = IdTable::Id(t.entries.size());
+    t.entries.append({text, parent});
+    t.byKey.insert(key, id);
+    return id;
+}
+
+IdTable::Id intern(IdTable::Id parent, const QString &text)
+{
+    Table &t = table();
+    if (const IdTable::Id id = lookup(t, parent, text)) {
+        return id;
+    }
+    return insert(t, parent, text);
+}
+
+} // namespace
+
+IdTable::Id IdTable::collection(const QString &collectionId)
+{
+    const Id id = intern(0, collectionId);
+    Table &t = table();
+    {
+        QReadLocker locker(&t.lock);
+        if (t.collections.contains(collectionId)) {
+            return id;
+        }
+    }
+    QWriteLocker locker(&t.lock);
+    t.collections.insert(collectionId, id);
+    return id;
+}
+
+IdTable::Id IdTable::calendar(const QString &collectionId, const QString &calId)
+{
+    Table &t = table();
+    {
+        QReadLocker locker(&t.lock);
+        if (const Id id = t.calendars.value(calId, 0)) {
+            return id;
+        }
+    }
+    const Id id = intern(collection(collectionId), calId);
+    QWriteLocker locker(&t.lock);
+    const auto it = t.calendars.constFind(calId);
+    if (it != t.calendars.constEnd()) {
+        return it.value(); // First registration wins
+    }
+    t.calendars.insert(calId, id);
+    return id;
+}
+
+IdTable::Id IdTable::calendar(const QString &calId)
+{
+    qsizetype separator = calId.indexOf(QLatin1Char('_'));
+    {
+        Table &t = table();
+        QReadLocker locker(&t.lock);
+        if (const Id id = t.calendars.value(calId, 0)) {
+            return id;
+        }
+        // Both halves may contain '_', so prefer the longest prefix that is a known collection
+        for (qsizetype at = calId.lastIndexOf(QLatin1Char('_')); at > 0; at = calId.lastIndexOf(QLatin1Char('_'), at - 1)) {
+            if (t.collections.contains(calId.left(at))) {
+                separator = at;
+                break;
+            }
+        }
+    }
+    return calendar(separator < 0 ? calId : calId.left(separator), calId);
+}
+
+IdTable::Id IdTable::item(Id calendar, const QString &uid)
+{
+    return intern(calendar, uid);
+}
+
+IdTable::Id IdTable::findItem(Id calendar, const QString &uid)
+{
+    return lookup(table(), calendar, uid);
+}
+
+QString IdTable::text(Id id)
+{
+    Table &t = table();
+    QReadLocker locker(&t.lock);
+    return id < Id(t.entries.size()) ? t.entries.at(id).text : QString();
+}
+
+IdTable::Id IdTable::parent(Id id)
+{
+    Table &t = table();
+    QReadLocker locker(&t.lock);
+    return id < Id(t.entries.size()) ? t.entries.at(id).parent : 0;
+}
+
+int IdTable::size()
+{
+    Table &t = table();
+    QReadLocker locker(&t.lock);
+    return int(t.entries.size()) - 1;
+}
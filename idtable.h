@@ -0,0 +1,29 @@
+#ifndef IDTABLE_H
+#define IDTABLE_H
+
+#include <QString>
+
+// Process-wide table of interned identifiers. Collections, calendars and items each get a small
+// integer handle; a calendar remembers its collection and an item its calendar, so walking up is O(1)
+// and never re-parses "collection_calendar" strings. Handles are never released. Thread-safe.
+class IdTable
+{
+public:
+    using Id = quint32; // 0 is the null handle
+
+    static Id collection(const QString &collectionId);
+    static Id calendar(const QString &collectionId, const QString &calId);
+    // A calendar registered earlier, else one under the longest known collection id that prefixes it,
+    // else one whose collection is the prefix before the first '_'
+    static Id calendar(const QString &calId);
+    static Id item(Id calendar, const QString &uid);
+    static Id findItem(Id calendar, const QString &uid); // 0 if never interned
+
+    static QString text(Id id);
+    static Id parent(Id id); // Item -> calendar -> collection -> 0
+    static QString collectionIdOf(const QString &calId) { return text(parent(calendar(calId))); }
+
+    static int size();
+};
+
+#endif // IDTABLE_H
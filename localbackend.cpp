@@ -1,19 +1,64 @@
 #include "localbackend.h"
 #include "cal.h"
 #include "calendaritem.h"
+#include "icsstreamreader.h"
 #include <KCalendarCore/ICalFormat>
 #include <KCalendarCore/MemoryCalendar>
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
-#include <QCryptographicHash>
+#include <QThread>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace {
+
+CalendarItem::Header itemHeader(const IcsHeaderScanner::Header &scanned)
+{
+    CalendarItem::Header header;
+    header.summary = scanned.summary;
+    header.dtStart = scanned.dtStart;
+    header.dtEndOrDue = scanned.type == IcsHeaderScanner::Type::Todo ? scanned.due : scanned.dtEnd;
+    header.allDay = scanned.allDay;
+    header.recurs = !scanned.rrule.isEmpty();
+    header.relatedTo = scanned.relatedTo;
+    header.percentComplete = scanned.percentComplete;
+    header.transparent = scanned.transparent;
+    header.categories = scanned.categories;
+    return header; // The scanner declines overrides, so recurrenceId stays unset
+}
+
+// File name for an item exploded out of an import; UIDs are free text, so anything unusual is hashed
+QString explodedFileName(const QString &itemUid)
+{
+    static const QRegularExpression plainName("^[A-Za-z0-9@-][A-Za-z0-9@.-]{0,199}$");
+    if (plainName.match(itemUid).hasMatch()) {
+        return itemUid + ".ics";
+    }
+    const QByteArray key = itemUid.toUtf8();
+    return QString::number(ContentHash::xxHash64(key.constData(), key.size()), 16) + ".ics";
+}
+
+} // namespace
 
 LocalBackend::LocalBackend(const QString &rootPath, QObject *parent)
-    : SyncBackend(parent), m_rootPath(rootPath)
+    : SyncBackend(parent), m_rootPath(rootPath), m_watchTimer(new QTimer(this))
 {
+    m_watchTimer->setSingleShot(true);
+    m_watchTimer->setInterval(300);
+    connect(m_watchTimer, &QTimer::timeout, this, &LocalBackend::processWatchedChanges);
+    m_loadPool.setMaxThreadCount(effectiveLoadWorkerCount());
     qDebug() << "LocalBackend: Initialized with rootPath" << m_rootPath;
 }
 
+LocalBackend::~LocalBackend()
+{
+    stopSyncThread(); // Pending queued deliveries die with this object
+    stopImportThread();
+}
+
 QList<CalendarMetadata> LocalBackend::loadCalendars(const QString &collectionId)
 {
     qDebug() << "LocalBackend: Loading calendars for collection" << collectionId;
@@ -28,6 +73,7 @@ QList<CalendarMetadata> LocalBackend::loadCalendars(const QString &collectionId)
         CalendarMetadata meta;
         meta.id = collectionId + "_" + dirName.toLower().replace(" ", "_");
         meta.name = dirName;
+        IdTable::calendar(collectionId, meta.id);
         calendars.append(meta);
         qDebug() << "LocalBackend: Added calendar" << meta.id << meta.name;
     }
@@ -45,96 +91,602 @@ QList<QSharedPointer<CalendarItem>> LocalBackend::loadItems(Cal *cal)
         return items;
     }
 
-    QString calDirPath = QDir(m_rootPath).filePath(cal->name());
+    // Read + parse fans out across the pool; items are still built here so they live on the caller's thread
+    const QList<LoadedItem> loaded = buildItems(calId, parseIcsFiles(icsFilePaths(cal->name()), nullptr, m_lazyLoading),
+                                                 m_hashAlgorithm, m_lazyLoading);
+    m_calDirs[QDir(m_rootPath).filePath(cal->name())] = CalendarMetadata{calId, cal->name()};
+    items.reserve(loaded.size());
+    for (const LoadedItem &entry : loaded) {
+        items.append(entry.item);
+        recordLoadedFile(entry);
+    }
+
+    qDebug() << "LocalBackend: Loaded" << items.size() << "items for calendar" << cal->name();
+    return items; // No signals here—let startSync handle it
+}
+
+QStringList LocalBackend::icsFilePaths(const QString &calName) const
+{
+    QStringList filePaths;
+    QString calDirPath = QDir(m_rootPath).filePath(calName);
     QDir calDir(calDirPath);
     if (!calDir.exists()) {
-        qDebug() << "LocalBackend: No directory found for" << cal->name() << "at" << calDirPath;
-        return items;
+        qDebug() << "LocalBackend: No directory found for" << calName << "at" << calDirPath;
+        return filePaths;
     }
 
     QStringList icsFiles = calDir.entryList({"*.ics"}, QDir::Files);
     qDebug() << "LocalBackend: Found" << icsFiles.size() << "ICS files in" << calDirPath;
-    KCalendarCore::ICalFormat format;
+    filePaths.reserve(icsFiles.size());
     for (const QString &fileName : icsFiles) {
-        QString filePath = calDir.filePath(fileName);
-        QFile file(filePath);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qWarning() << "LocalBackend: Failed to open" << filePath << ":" << file.errorString();
+        filePaths.append(calDir.filePath(fileName));
+    }
+    return filePaths;
+}
+
+QList<LocalBackend::LoadedItem> LocalBackend::buildItems(const QString &calId, const QList<ParsedIcsFile> &parsedFiles,
+                                                         ContentHash::Algorithm algorithm, bool lazy)
+{
+    QList<LoadedItem> loaded;
+    loaded.reserve(parsedFiles.size());
+    for (const ParsedIcsFile &parsed : parsedFiles) {
+        if (!parsed.isValid()) {
             continue;
         }
 
-        QString icalData = QString::fromUtf8(file.readAll());
-        file.close();
-        if (icalData.isEmpty()) {
-            qWarning() << "LocalBackend: Empty ICS data in" << filePath;
+        const QString &filePath = parsed.filePath;
+        KCalendarCore::Incidence::Ptr incidence = parsed.incidence;
+        QString itemUid = parsed.headerOnly ? parsed.header.uid : itemUidFor(incidence);
+        if (itemUid.isEmpty()) {
+            qDebug() << "LocalBackend: Empty UID in" << filePath << "- generating fallback";
+            itemUid = QString::number(qHash(filePath));
+            if (itemUid == "0" || itemUid.isEmpty()) {
+                itemUid = QString("fallback_%1").arg(QDateTime::currentMSecsSinceEpoch());
+            }
+        }
+
+        QSharedPointer<CalendarItem> item;
+        if (parsed.headerOnly) {
+            if (parsed.header.type == IcsHeaderScanner::Type::Event) {
+                item = QSharedPointer<Event>::create(calId, itemUid);
+            } else {
+                item = QSharedPointer<Todo>::create(calId, itemUid);
+            }
+        } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeEvent) {
+            item = QSharedPointer<Event>::create(calId, itemUid);
+        } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeTodo) {
+            item = QSharedPointer<Todo>::create(calId, itemUid);
+        } else {
+            qWarning() << "LocalBackend: Unsupported incidence type" << incidence->type() << "in" << filePath;
             continue;
         }
 
+        if (lazy) {
+            // Only the header stays resident; the full parser runs again on first use
+            const QString expectedVersion = parsed.versionIdentifier;
+            const CalendarItem::Header header = parsed.headerOnly ? itemHeader(parsed.header) : CalendarItem::headerFor(incidence);
+            item->setLazyIncidence(header, [filePath, algorithm, expectedVersion]() {
+                ParsedIcsFile reloaded = parseIcsFile(filePath, algorithm);
+                if (reloaded.incidence && reloaded.versionIdentifier != expectedVersion) {
+                    qWarning() << "LocalBackend:" << filePath << "changed since it was indexed; loading current content";
+                }
+                return reloaded.incidence;
+            });
+        } else {
+            item->setIncidence(incidence);
+        }
+        item->setLastModified(parsed.lastModified);
+        item->setVersionIdentifier(parsed.versionIdentifier); // Content hash stands in for an ETag
+        loaded.append({item, filePath, parsed.lastModified, parsed.size});
+    }
+    return loaded;
+}
+
+QString LocalBackend::itemUidFor(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    QString uid = incidence->uid();
+    if (!uid.isEmpty() && incidence->hasRecurrenceId()) {
+        // Overrides share the series UID; the instance they replace keeps them apart
+        uid += "-" + incidence->recurrenceId().toUTC().toString("yyyyMMdd'T'HHmmss'Z'");
+    }
+    return uid;
+}
+
+void LocalBackend::setLoadWorkerCount(int count)
+{
+    m_loadWorkerCount = qMax(0, count);
+    m_loadPool.setMaxThreadCount(effectiveLoadWorkerCount()); // Here, on our own thread, never from a sync worker
+    qDebug() << "LocalBackend: Load worker count set to" << m_loadWorkerCount << "for" << m_rootPath;
+}
+
+void LocalBackend::setHashAlgorithm(ContentHash::Algorithm algorithm)
+{
+    if (m_hashAlgorithm == algorithm) return;
+    m_hashAlgorithm = algorithm;
+    m_idToVersion.clear(); // Identifiers from different algorithms never compare equal
+    qDebug() << "LocalBackend: Hash algorithm set to" << ContentHash::algorithmName(algorithm) << "for" << m_rootPath;
+}
+
+int LocalBackend::effectiveLoadWorkerCount() const
+{
+    return m_loadWorkerCount > 0 ? m_loadWorkerCount : QThread::idealThreadCount();
+}
+
+LocalBackend::ParsedIcsFile LocalBackend::parseIcsFile(const QString &filePath, ContentHash::Algorithm algorithm, bool headerOnly)
+{
+    // Runs on pool threads: touch nothing but the file and locals
+    ParsedIcsFile result;
+    result.filePath = filePath;
+
+    // Binary read so the hash covers exactly the bytes on disk
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "LocalBackend: Failed to open" << filePath << ":" << file.errorString();
+        return result;
+    }
+
+    const QByteArray rawData = file.readAll();
+    file.close();
+    result = parseIcsData(filePath, rawData, algorithm, headerOnly);
+    if (result.isValid()) {
+        const QFileInfo info(filePath);
+        result.lastModified = info.lastModified();
+        result.size = info.size();
+    }
+    return result;
+}
+
+LocalBackend::ParsedIcsFile LocalBackend::parseIcsData(const QString &filePath, const QByteArray &rawData,
+                                                       ContentHash::Algorithm algorithm, bool headerOnly)
+{
+    ParsedIcsFile result;
+    result.filePath = filePath;
+    if (rawData.isEmpty()) {
+        qWarning() << "LocalBackend: Empty ICS data in" << filePath;
+        return result;
+    }
+
+    // Indexing only needs the header fields; the scanner declines anything it cannot represent exactly
+    if (headerOnly && IcsHeaderScanner::scan(rawData, &result.header)) {
+        result.headerOnly = true;
+    } else {
+        KCalendarCore::ICalFormat format;
         KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
-        if (!format.fromString(tempCalendar, icalData)) {
+        if (!format.fromString(tempCalendar, QString::fromUtf8(rawData))) {
             qWarning() << "LocalBackend: Failed to parse ICS data from" << filePath;
-            continue;
+            return result;
         }
 
         KCalendarCore::Incidence::List incidences = tempCalendar->incidences();
         if (incidences.isEmpty()) {
             qWarning() << "LocalBackend: No incidences found in" << filePath;
-            continue;
+            return result;
         }
-
-        KCalendarCore::Incidence::Ptr incidence = incidences.first();
-        QString itemUid = incidence->uid();
-        if (itemUid.isEmpty()) {
-            qDebug() << "LocalBackend: Empty UID in" << filePath << "- generating fallback";
-            itemUid = QString::number(qHash(filePath));
-            if (itemUid == "0" || itemUid.isEmpty()) {
-                itemUid = QString("fallback_%1").arg(QDateTime::currentMSecsSinceEpoch());
+        result.incidence = incidences.first();
+        for (const KCalendarCore::Incidence::Ptr &incidence : std::as_const(incidences)) {
+            if (!incidence->hasRecurrenceId()) {
+                result.incidence = incidence; // Prefer the series over its overrides
+                break;
             }
         }
-        QString itemId = calId + "_" + itemUid;
+    }
 
-        QSharedPointer<CalendarItem> item;
-        if (incidence->type() == KCalendarCore::IncidenceBase::TypeEvent) {
-            item = QSharedPointer<CalendarItem>(new Event(calId, itemUid, nullptr));
-        } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeTodo) {
-            item = QSharedPointer<CalendarItem>(new Todo(calId, itemUid, nullptr));
+    result.versionIdentifier = ContentHash::versionIdentifier(rawData, algorithm);
+    return result;
+}
+
+LocalBackend::ParsedIcsFile LocalBackend::loadIcsFile(const QString &filePath, const QString &snapshotKey,
+                                                     ContentHash::Algorithm algorithm, const SnapshotCache *snapshot,
+                                                     bool headerOnly)
+{
+    // Stat before reading: if the file changes in between, the recorded mtime is stale and the next open re-parses
+    const QFileInfo info(filePath);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+
+    SnapshotCache::Entry entry;
+    if (snapshot->find(snapshotKey, mtime, size, &entry)) {
+        // Header-only entries serve indexing; a full load needs an entry that carries the incidence
+        ParsedIcsFile result;
+        if (headerOnly && !entry.headerData.isEmpty()) {
+            result.headerOnly = SnapshotCache::decodeHeader(entry.headerData, &result.header);
+        } else if (!entry.incidenceData.isEmpty()) {
+            result.incidence = SnapshotCache::decodeIncidence(entry.incidenceData);
+        }
+        if (result.isValid()) {
+            result.filePath = filePath;
+            result.lastModified = info.lastModified();
+            result.size = size;
+            result.versionIdentifier = entry.versionIdentifier;
+            result.fromSnapshot = true;
+            result.snapshotKey = snapshotKey;
+            result.snapshotEntry = entry;
+            return result;
+        }
+        if (!entry.incidenceData.isEmpty() || headerOnly) {
+            qDebug() << "LocalBackend: Snapshot entry for" << snapshotKey << "is unreadable—re-parsing";
+        }
+    }
+
+    ParsedIcsFile result = parseIcsFile(filePath, algorithm, headerOnly);
+    result.snapshotKey = snapshotKey;
+    if (result.isValid()) {
+        result.snapshotEntry.mtime = mtime;
+        result.snapshotEntry.size = size;
+        result.snapshotEntry.versionIdentifier = result.versionIdentifier;
+        if (result.headerOnly) {
+            result.snapshotEntry.headerData = SnapshotCache::encodeHeader(result.header);
         } else {
-            qWarning() << "LocalBackend: Unsupported incidence type" << incidence->type() << "in" << filePath;
-            continue;
+            result.snapshotEntry.incidenceData = SnapshotCache::encodeIncidence(result.incidence);
+        }
+    }
+    return result;
+}
+
+QList<LocalBackend::ParsedIcsFile> LocalBackend::parseIcsFiles(const QStringList &filePaths, const SnapshotCache *snapshot,
+                                                               bool headerOnly)
+{
+    const int workers = effectiveLoadWorkerCount();
+    const ContentHash::Algorithm algorithm = m_hashAlgorithm;
+    const QDir rootDir(m_rootPath);
+    auto load = [algorithm, snapshot, rootDir, headerOnly](const QString &filePath) {
+        if (!snapshot) {
+            return parseIcsFile(filePath, algorithm, headerOnly);
         }
+        return loadIcsFile(filePath, rootDir.relativeFilePath(filePath), algorithm, snapshot, headerOnly);
+    };
 
-        item->setIncidence(incidence);
-        QFileInfo fileInfo(filePath);
-        item->setLastModified(fileInfo.lastModified());
-        item->setVersionIdentifier(""); // No ETag for local files
-        items.append(item);
-        m_idToPath[itemId] = filePath;
+    if (workers <= 1 || filePaths.size() < 2) {
+        QList<ParsedIcsFile> results;
+        results.reserve(filePaths.size());
+        for (const QString &filePath : filePaths) {
+            results.append(load(filePath));
+        }
+        return results;
     }
 
-    qDebug() << "LocalBackend: Loaded" << items.size() << "items for calendar" << cal->name();
-    return items; // No signals here—let startSync handle it
+    qDebug() << "LocalBackend: Parsing" << filePaths.size() << "files with" << workers << "workers";
+    // blockingMapped preserves input order, so results match the sequential path exactly
+    return QtConcurrent::blockingMapped<QList<ParsedIcsFile>>(&m_loadPool, filePaths, load);
+}
+
+void LocalBackend::setSnapshotPath(const QString &path)
+{
+    m_snapshotPath = path;
+    qDebug() << "LocalBackend: Snapshot path for" << m_rootPath << "set to" << path;
+}
+
+void LocalBackend::setSyncBatchSize(int size)
+{
+    m_syncBatchSize = qMax(1, size);
 }
 
 void LocalBackend::startSync(const QString &collectionId)
 {
     qDebug() << "LocalBackend: Starting sync for collection" << collectionId;
+    if (m_syncThread) {
+        qWarning() << "LocalBackend: Sync already running for" << m_rootPath << "- ignoring request for" << collectionId;
+        return;
+    }
 
+    // Directory listing is cheap; announce calendars up front so the real Cal objects exist before any batch arrives
     QList<CalendarMetadata> calendars = loadCalendars(collectionId);
     for (const CalendarMetadata &meta : calendars) {
+        m_syncCals[meta.id] = new Cal(meta.id, meta.name, nullptr);
+        const QString dirPath = QDir(m_rootPath).filePath(meta.name);
+        m_calDirs[dirPath] = meta;
+        m_fileState.remove(dirPath); // Rebuilt from this sync's batches
         emit calendarDiscovered(collectionId, meta);
-        Cal tempCal(meta.id, meta.name, nullptr); // Stack-allocated
-        QList<QSharedPointer<CalendarItem>> items = loadItems(&tempCal);
-        qDebug() << "LocalBackend: Loaded" << items.size() << "items for" << meta.id;
-        for (const QSharedPointer<CalendarItem> &item : items) {
-            QString verId = fetchItemVersionIdentifier(tempCal.id(), item->id());
-            emit itemLoaded(&tempCal, item, verId);
+    }
+
+    const int batchSize = m_syncBatchSize;
+    const QString snapshotPath = m_snapshotPath;
+    const ContentHash::Algorithm algorithm = m_hashAlgorithm;
+    const QString hashName = ContentHash::algorithmName(algorithm);
+    const bool lazy = m_lazyLoading;
+    m_syncCancelled = false;
+    m_syncThread = QThread::create([this, collectionId, calendars, batchSize, snapshotPath, algorithm, hashName, lazy]() {
+        // Unchanged files come from the previous snapshot; everything seen this run goes into the next one
+        const bool useSnapshot = !snapshotPath.isEmpty();
+        SnapshotCache previous(snapshotPath);
+        SnapshotCache next(snapshotPath);
+        if (useSnapshot) {
+            previous.setHashAlgorithm(hashName);
+            previous.load();
+            next.setHashAlgorithm(hashName);
+        }
+        int snapshotHits = 0;
+        int filesSeen = 0;
+
+        for (const CalendarMetadata &meta : calendars) {
+            const QStringList filePaths = icsFilePaths(meta.name);
+            for (int offset = 0; offset < filePaths.size(); offset += batchSize) {
+                if (m_syncCancelled) {
+                    return;
+                }
+                const QList<ParsedIcsFile> parsed = parseIcsFiles(filePaths.mid(offset, batchSize), useSnapshot ? &previous : nullptr, lazy);
+                if (useSnapshot) {
+                    for (const ParsedIcsFile &file : parsed) {
+                        if (!file.isValid()) continue;
+                        next.insert(file.snapshotKey, file.snapshotEntry);
+                        ++filesSeen;
+                        if (file.fromSnapshot) ++snapshotHits;
+                    }
+                }
+                QList<LoadedItem> batch = buildItems(meta.id, parsed, algorithm, lazy);
+                QString calId = meta.id;
+                QMetaObject::invokeMethod(this, [this, calId, batch]() {
+                    deliverItemBatch(calId, batch);
+                }, Qt::QueuedConnection);
+            }
+            QString calId = meta.id;
+            QMetaObject::invokeMethod(this, [this, calId]() {
+                finishCalendar(calId);
+            }, Qt::QueuedConnection);
+        }
+
+        // Rewrite only when something changed, so a clean warm start does no snapshot I/O beyond the read
+        if (useSnapshot && (snapshotHits != filesSeen || previous.size() != next.size())) {
+            next.save();
         }
-        emit calendarLoaded(&tempCal);
+        QMetaObject::invokeMethod(this, [this, collectionId, snapshotHits]() {
+            finishSync(collectionId, snapshotHits);
+        }, Qt::QueuedConnection);
+    });
+    m_syncThread->setObjectName("LocalBackendSync");
+    m_syncThread->start();
+}
+
+void LocalBackend::deliverItemBatch(const QString &calId, const QList<LoadedItem> &batch)
+{
+    Cal *cal = m_syncCals.value(calId);
+    if (!cal) {
+        qWarning() << "LocalBackend: No sync calendar for" << calId << "- dropping batch of" << batch.size();
+        return;
     }
 
+    QList<QSharedPointer<CalendarItem>> items;
+    items.reserve(batch.size());
+    for (const LoadedItem &entry : batch) {
+        recordLoadedFile(entry);
+        items.append(entry.item);
+    }
+    qDebug() << "LocalBackend: Delivering batch of" << items.size() << "items for" << calId;
+    emit itemsLoaded(cal, items);
+}
+
+void LocalBackend::finishCalendar(const QString &calId)
+{
+    if (Cal *cal = m_syncCals.value(calId)) {
+        emit calendarLoaded(cal);
+    }
+}
+
+void LocalBackend::finishSync(const QString &collectionId, int snapshotHits)
+{
+    stopSyncThread();
+    m_lastSyncSnapshotHits = snapshotHits;
+    qDebug() << "LocalBackend: Sync finished for" << collectionId << "with" << snapshotHits << "items from snapshot";
+    if (m_watchEnabled) {
+        startWatching();
+    }
     emit syncCompleted(collectionId);
 }
 
+void LocalBackend::stopSyncThread()
+{
+    if (m_syncThread) {
+        m_syncCancelled = true;
+        m_syncThread->wait();
+        delete m_syncThread;
+        m_syncThread = nullptr;
+    }
+    qDeleteAll(m_syncCals);
+    m_syncCals.clear();
+}
+
+bool LocalBackend::importIcsFile(const QString &sourcePath, const CalendarMetadata &calendar, bool explode)
+{
+    if (m_importThread) {
+        qWarning() << "LocalBackend: Import already running for" << m_rootPath << "- ignoring" << sourcePath;
+        return false;
+    }
+    if (!QFileInfo(sourcePath).isReadable()) {
+        qWarning() << "LocalBackend: Cannot read import file" << sourcePath;
+        emit errorOccurred("Cannot read import file: " + sourcePath);
+        return false;
+    }
+    const QString calDirPath = QDir(m_rootPath).filePath(calendar.name);
+    if (explode) {
+        if (!QDir().mkpath(calDirPath)) {
+            qWarning() << "LocalBackend: Failed to create directory" << calDirPath;
+            emit errorOccurred("Failed to create calendar directory: " + calDirPath);
+            return false;
+        }
+        m_calDirs[calDirPath] = calendar;
+    }
+
+    const int batchSize = m_syncBatchSize;
+    const int workers = effectiveLoadWorkerCount();
+    const ContentHash::Algorithm algorithm = m_hashAlgorithm;
+    const GroupCommitWriter::Durability durability = m_writeDurability;
+    const bool lazy = m_lazyLoading && explode; // Lazy items re-read their own file, which only exists when exploded
+    m_importCancelled = false;
+    m_importThread = QThread::create([this, sourcePath, calendar, explode, calDirPath, batchSize, workers, algorithm,
+                                      durability, lazy]() {
+        const QString calId = calendar.id;
+        QFile file(sourcePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            const QString error = file.errorString();
+            QMetaObject::invokeMethod(this, [this, calId, sourcePath, error]() {
+                emit errorOccurred("Failed to open " + sourcePath + ": " + error);
+                finishImport(calId, 0, 0);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        // Only one batch of raw components and their parsed items is resident at a time
+        const qint64 totalBytes = file.size();
+        IcsStreamReader reader(&file);
+        const QDir calDir(calDirPath);
+        QSet<QString> seenUids; // A calendar holds each UID once; later copies are dropped
+        int imported = 0;
+        int failed = 0;
+        QList<QByteArray> chunks;
+        QByteArray chunk;
+        bool more = true;
+        while (more && !m_importCancelled) {
+            chunks.clear();
+            while (chunks.size() < batchSize && (more = reader.readNext(&chunk))) {
+                chunks.append(chunk);
+            }
+            if (chunks.isEmpty()) {
+                break;
+            }
+
+            // Each chunk is a self-contained VCALENDAR, so parsing fans out without shared state
+            auto parse = [algorithm](const QByteArray &data) {
+                ParsedIcsFile parsed = parseIcsData(QString(), data, algorithm, false);
+                if (parsed.incidence && parsed.incidence->uid().isEmpty()) {
+                    // Derived from the content so re-importing the same file yields the same id
+                    parsed.incidence->setUid(QString::number(ContentHash::xxHash64(data.constData(), data.size()), 16));
+                    parsed.uidDerived = true;
+                }
+                return parsed;
+            };
+            QList<ParsedIcsFile> parsed;
+            if (workers <= 1) {
+                parsed.reserve(chunks.size());
+                for (const QByteArray &data : std::as_const(chunks)) {
+                    parsed.append(parse(data));
+                }
+            } else {
+                parsed = QtConcurrent::blockingMapped<QList<ParsedIcsFile>>(&m_loadPool, chunks, parse);
+            }
+
+            QList<int> toWrite;
+            for (int i = 0; i < parsed.size(); ++i) {
+                ParsedIcsFile &entry = parsed[i];
+                if (!entry.incidence) continue;
+                const QString itemUid = itemUidFor(entry.incidence);
+                if (seenUids.contains(itemUid)) {
+                    qWarning() << "LocalBackend: Duplicate UID" << itemUid << "in" << sourcePath << "- keeping the first copy";
+                    entry.incidence.reset();
+                    continue;
+                }
+                seenUids.insert(itemUid);
+                if (explode) {
+                    entry.filePath = calDir.filePath(explodedFileName(itemUid));
+                    if (entry.uidDerived) {
+                        // Write the generated UID out so loading the file later yields the same id
+                        chunks[i] = CalendarItem::serialize(entry.incidence);
+                        entry.versionIdentifier = ContentHash::versionIdentifier(chunks.at(i), algorithm);
+                    }
+                    toWrite.append(i);
+                } else {
+                    entry.versionIdentifier.clear(); // Nothing on disk yet
+                    entry.lastModified = entry.incidence->lastModified().isValid() ? entry.incidence->lastModified()
+                                                                                   : QDateTime::currentDateTimeUtc();
+                }
+            }
+
+            if (explode) {
+                // Temp files are written in parallel, then renamed into place as one group
+                GroupCommitWriter writer(durability);
+                ParsedIcsFile *entries = parsed.data();
+                auto stage = [&writer, entries, &chunks](int index) {
+                    if (!writer.stage(entries[index].filePath, chunks.at(index))) {
+                        entries[index].incidence.reset();
+                    }
+                };
+                if (workers <= 1) {
+                    for (int index : std::as_const(toWrite)) stage(index);
+                } else {
+                    QtConcurrent::blockingMap(&m_loadPool, toWrite, stage);
+                }
+                const GroupCommitWriter::Result result = writer.commit();
+                const QSet<QString> written(result.writtenPaths.cbegin(), result.writtenPaths.cend());
+                for (int index : std::as_const(toWrite)) {
+                    ParsedIcsFile &entry = parsed[index];
+                    if (!entry.incidence) continue;
+                    if (!written.contains(entry.filePath)) {
+                        entry.incidence.reset();
+                        continue;
+                    }
+                    const QFileInfo info(entry.filePath);
+                    entry.lastModified = info.lastModified();
+                    entry.size = info.size();
+                }
+            }
+
+            QList<LoadedItem> batch = buildItems(calId, parsed, algorithm, lazy);
+            for (const LoadedItem &entry : batch) {
+                if (!explode) {
+                    entry.item->setDirty(true); // Written out by the next commit
+                }
+            }
+            imported += batch.size();
+            failed += int(chunks.size() - batch.size());
+            const qint64 bytesRead = reader.bytesRead();
+            QMetaObject::invokeMethod(this, [this, calId, batch, explode, bytesRead, totalBytes]() {
+                deliverImportBatch(calId, batch, explode);
+                emit importProgress(calId, bytesRead, totalBytes);
+            }, Qt::QueuedConnection);
+        }
+
+        qDebug() << "LocalBackend: Streamed" << reader.componentsRead() << "components from" << sourcePath << "-"
+                 << reader.componentsSkipped() << "skipped," << imported << "imported," << failed << "failed";
+        QMetaObject::invokeMethod(this, [this, calId, imported, failed]() {
+            finishImport(calId, imported, failed);
+        }, Qt::QueuedConnection);
+    });
+    m_importThread->setObjectName("LocalBackendImport");
+    m_importThread->start();
+    qDebug() << "LocalBackend: Importing" << sourcePath << "into" << calendar.id << (explode ? "as separate files" : "");
+    return true;
+}
+
+void LocalBackend::cancelImport()
+{
+    m_importCancelled = true; // The worker stops after its current batch and still reports importFinished
+}
+
+void LocalBackend::deliverImportBatch(const QString &calId, const QList<LoadedItem> &batch, bool explode)
+{
+    QList<QSharedPointer<CalendarItem>> items;
+    items.reserve(batch.size());
+    QStringList watchPaths;
+    for (const LoadedItem &entry : batch) {
+        if (explode) {
+            recordLoadedFile(entry);
+            watchPaths.append(entry.filePath);
+        }
+        items.append(entry.item);
+    }
+    if (m_watcher && !watchPaths.isEmpty()) {
+        m_watcher->addPaths(watchPaths);
+    }
+    qDebug() << "LocalBackend: Delivering" << items.size() << "imported items for" << calId;
+    emit itemsAdded(calId, items);
+}
+
+void LocalBackend::finishImport(const QString &calId, int imported, int failed)
+{
+    stopImportThread();
+    qDebug() << "LocalBackend: Import into" << calId << "finished with" << imported << "items," << failed << "failed";
+    emit importFinished(calId, imported, failed);
+}
+
+void LocalBackend::stopImportThread()
+{
+    if (m_importThread) {
+        m_importCancelled = true;
+        m_importThread->wait();
+        delete m_importThread;
+        m_importThread = nullptr;
+    }
+}
+
 void LocalBackend::storeCalendars(const QString &collectionId, const QList<Cal*> &calendars)
 {
     qDebug() << "LocalBackend: Storing calendars for collection" << collectionId << "with" << calendars.size() << "calendars";
@@ -180,34 +732,39 @@ void LocalBackend::storeItems(Cal *cal, const QList<QSharedPointer<CalendarItem>
         return;
     }
 
-    KCalendarCore::ICalFormat format;
+    const bool ownsGroup = !m_commit;
+    if (ownsGroup) {
+        beginCommit();
+    }
+
     for (const QSharedPointer<CalendarItem> &item : items) {
-        if (!item || !item->incidence()) {
+        if (!item) {
             qDebug() << "LocalBackend: Skipping invalid item in storeItems";
             continue;
         }
 
-        QString itemUid = item->id().split("_").last();
-        QString fileName = QString("%1.ics").arg(itemUid);
-        QString filePath = calDir.filePath(fileName);
-        QFile file(filePath);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            qWarning() << "LocalBackend: Failed to open" << filePath << ":" << file.errorString();
-            emit errorOccurred("Failed to write item: " + file.errorString());
-            continue;
+        // Items stay in the file they were read from; new ones are named after their UID
+        QString filePath = m_idToPath.value(item->handle());
+        if (filePath.isEmpty() || QFileInfo(filePath).absolutePath() != calDir.absolutePath()) {
+            filePath = calDir.filePath(QString("%1.ics").arg(item->id()));
         }
 
-        KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
-        tempCalendar->addIncidence(item->incidence());
-        QString icalData = format.toString(tempCalendar);
-        if (file.write(icalData.toUtf8()) == -1) {
-            qWarning() << "LocalBackend: Write failed for" << filePath << ":" << file.errorString();
-            emit errorOccurred("Write failed: " + file.errorString());
-        } else {
-            qDebug() << "LocalBackend: Saved" << item->type() << item->id() << "to" << filePath;
-            m_idToPath[item->id()] = filePath;
+        // Same revision we last read or wrote: the file already has this content, skip serializing
+        if (m_idToRevision.value(item->handle()) == item->revision() && isCurrentFile(item->handle(), filePath)) {
+            ++m_elidedWrites;
+            continue;
+        }
+        // Same bytes the session journal recorded for this revision, serialized at most once
+        const QByteArray data = item->icalData();
+        if (data.isEmpty()) {
+            qDebug() << "LocalBackend: Skipping invalid item in storeItems";
+            continue;
         }
-        file.close();
+        stageWrite(item->handle(), item->id(), filePath, data, item->revision());
+    }
+
+    if (ownsGroup) {
+        endCommit();
     }
     // No dataLoaded—caller should handle completion
 }
@@ -215,37 +772,37 @@ void LocalBackend::storeItems(Cal *cal, const QList<QSharedPointer<CalendarItem>
 void LocalBackend::updateItem(const QString &calId, const QString &itemId, const QString &icalData)
 {
     qDebug() << "LocalBackend: Updating item" << itemId << "for calendar" << calId;
-    QString fullId = calId + "_" + itemId;
-    QString filePath = m_idToPath.value(fullId);
+    const IdTable::Id handle = itemHandle(calId, itemId);
+    QString filePath = m_idToPath.value(handle);
     if (filePath.isEmpty()) {
-        qWarning() << "LocalBackend: No file path found for item" << fullId;
-        emit errorOccurred("No file path found for item: " + fullId);
+        qWarning() << "LocalBackend: No file path found for item" << itemId << "in" << calId;
+        emit errorOccurred("No file path found for item: " + itemId);
         return;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "LocalBackend: Failed to open" << filePath << ":" << file.errorString();
-        emit errorOccurred("Failed to write item: " + file.errorString());
-        return;
+    const bool ownsGroup = !m_commit;
+    if (ownsGroup) {
+        beginCommit();
     }
-
-    if (file.write(icalData.toUtf8()) == -1) {
-        qWarning() << "LocalBackend: Write failed for" << filePath << ":" << file.errorString();
-        emit errorOccurred("Write failed: " + file.errorString());
-    } else {
-        qDebug() << "LocalBackend: Updated item" << fullId << "at" << filePath;
+    stageWrite(handle, itemId, filePath, icalData.toUtf8(), 0);
+    if (ownsGroup) {
+        endCommit();
     }
-    file.close();
     // No dataLoaded—caller should handle completion
 }
 
 QString LocalBackend::fetchItemVersionIdentifier(const QString &calId, const QString &itemId)
 {
-    Q_UNUSED(calId);
-    QString filePath = m_idToPath.value(itemId);
+    // Loads and our own writes record the hash of the bytes they handled, so this normally never touches disk
+    const IdTable::Id handle = itemHandle(calId, itemId);
+    const QString cached = m_idToVersion.value(handle);
+    if (!cached.isEmpty()) {
+        return cached;
+    }
+
+    QString filePath = m_idToPath.value(handle);
     if (filePath.isEmpty()) {
-        qWarning() << "LocalBackend: No file path found for item" << itemId;
+        qWarning() << "LocalBackend: No file path found for item" << itemId << "in" << calId;
         return QString();
     }
     QFile file(filePath);
@@ -255,19 +812,18 @@ QString LocalBackend::fetchItemVersionIdentifier(const QString &calId, const QSt
     }
     QByteArray data = file.readAll();
     file.close();
-    // Use MD5 for a lightweight hash; collisions are extremely unlikely in our use case.
-    QByteArray md5 = QCryptographicHash::hash(data, QCryptographicHash::Md5);
-    QString verId = QString::fromUtf8(md5.toHex());
+    QString verId = ContentHash::versionIdentifier(data, m_hashAlgorithm);
+    m_idToVersion[handle] = verId;
     qDebug() << "LocalBackend: Computed version identifier for item" << itemId << ":" << verId;
     return verId;
 }
 
 void LocalBackend::removeItem(const QString &calId, const QString &itemId)
 {
-    Q_UNUSED(calId);
-    QString filePath = m_idToPath.value(itemId);
+    const IdTable::Id handle = itemHandle(calId, itemId);
+    QString filePath = m_idToPath.value(handle);
     if (filePath.isEmpty()) {
-        qWarning() << "LocalBackend: No file path found for item" << itemId;
+        qWarning() << "LocalBackend: No file path found for item" << itemId << "in" << calId;
         return;
     }
     QFile file(filePath);
@@ -275,10 +831,261 @@ void LocalBackend::removeItem(const QString &calId, const QString &itemId)
         if (!file.remove()) {
             qWarning() << "LocalBackend: Failed to remove file" << filePath << ":" << file.errorString();
         } else {
-            m_idToPath.remove(itemId);
+            forgetItem(handle);
+            forgetFile(filePath);
             qDebug() << "LocalBackend: Successfully removed item" << itemId;
         }
     } else {
         qWarning() << "LocalBackend: File" << filePath << "does not exist for item" << itemId;
     }
 }
+
+void LocalBackend::recordLoadedFile(const LoadedItem &entry)
+{
+    const IdTable::Id handle = entry.item->handle();
+    m_idToPath[handle] = entry.filePath;
+    m_idToVersion[handle] = entry.item->versionIdentifier();
+    m_idToRevision[handle] = entry.item->revision();
+
+    FileState state;
+    state.mtime = entry.fileModified.toMSecsSinceEpoch();
+    state.size = entry.fileSize;
+    state.itemId = entry.item->id();
+    m_fileState[QFileInfo(entry.filePath).path()][entry.filePath] = state;
+}
+
+void LocalBackend::recordWrittenFile(const QString &filePath, const QString &itemId)
+{
+    // Remember our own write so the watcher does not echo it back as an external change
+    const QFileInfo info(filePath);
+    FileState state;
+    state.mtime = info.lastModified().toMSecsSinceEpoch();
+    state.size = info.size();
+    state.itemId = itemId;
+    m_fileState[info.path()][filePath] = state;
+    if (m_watcher && !m_watcher->files().contains(filePath)) {
+        m_watcher->addPath(filePath);
+    }
+}
+
+void LocalBackend::forgetFile(const QString &filePath)
+{
+    auto dirIt = m_fileState.find(QFileInfo(filePath).path());
+    if (dirIt != m_fileState.end()) {
+        dirIt->remove(filePath);
+    }
+}
+
+void LocalBackend::setWatchEnabled(bool enabled)
+{
+    if (m_watchEnabled == enabled) return;
+    m_watchEnabled = enabled;
+    if (!enabled) {
+        delete m_watcher;
+        m_watcher = nullptr;
+        m_watchTimer->stop();
+        m_pendingDirs.clear();
+        qDebug() << "LocalBackend: Stopped watching" << m_rootPath;
+        return;
+    }
+    if (!m_calDirs.isEmpty() && !m_syncThread) {
+        startWatching(); // Already loaded; otherwise finishSync starts it
+    }
+}
+
+int LocalBackend::watchDebounceInterval() const
+{
+    return m_watchTimer->interval();
+}
+
+void LocalBackend::setWatchDebounceInterval(int msecs)
+{
+    m_watchTimer->setInterval(qMax(0, msecs));
+}
+
+void LocalBackend::startWatching()
+{
+    if (!m_watcher) {
+        m_watcher = new QFileSystemWatcher(this);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &LocalBackend::onWatchedPathChanged);
+        connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &LocalBackend::onWatchedPathChanged);
+    }
+
+    // Directories catch creates, deletes and renames; files catch in-place rewrites
+    QStringList paths;
+    for (auto dirIt = m_fileState.constBegin(); dirIt != m_fileState.constEnd(); ++dirIt) {
+        paths.append(dirIt.value().keys());
+    }
+    paths.append(m_calDirs.keys());
+    const QStringList failed = m_watcher->addPaths(paths);
+    if (!failed.isEmpty()) {
+        qWarning() << "LocalBackend: Could not watch" << failed.size() << "paths under" << m_rootPath
+                   << "- external edits to those files are only seen through directory changes";
+    }
+    qDebug() << "LocalBackend: Watching" << (paths.size() - failed.size()) << "paths under" << m_rootPath;
+}
+
+void LocalBackend::onWatchedPathChanged(const QString &path)
+{
+    if (!m_calDirs.contains(path) && QFileInfo::exists(path) && !m_watcher->files().contains(path)) {
+        m_watcher->addPath(path); // Replaced by rename; the watch on the old inode is gone
+    }
+    m_pendingDirs.insert(m_calDirs.contains(path) ? path : QFileInfo(path).path());
+    m_watchTimer->start(); // Restart: a burst of writes settles into one rescan
+}
+
+void LocalBackend::processWatchedChanges()
+{
+    if (m_syncThread || m_importThread) {
+        m_watchTimer->start(); // A full load or import is in flight; look again once it is done
+        return;
+    }
+    const QSet<QString> dirs = m_pendingDirs;
+    m_pendingDirs.clear();
+    for (const QString &dirPath : dirs) {
+        if (m_calDirs.contains(dirPath)) {
+            rescanDirectory(dirPath);
+        }
+    }
+}
+
+void LocalBackend::rescanDirectory(const QString &dirPath)
+{
+    const CalendarMetadata meta = m_calDirs.value(dirPath);
+    QHash<QString, FileState> &known = m_fileState[dirPath];
+    QDir dir(dirPath);
+
+    // Only files whose mtime or size moved are read again
+    QStringList changedPaths;
+    QSet<QString> present;
+    for (const QFileInfo &info : dir.entryInfoList({"*.ics"}, QDir::Files)) {
+        const QString filePath = dir.filePath(info.fileName());
+        present.insert(filePath);
+        auto it = known.constFind(filePath);
+        if (it == known.constEnd() || it->mtime != info.lastModified().toMSecsSinceEpoch() || it->size != info.size()) {
+            changedPaths.append(filePath);
+        }
+    }
+
+    QStringList removedIds;
+    for (auto it = known.begin(); it != known.end(); ) {
+        if (!present.contains(it.key())) {
+            removedIds.append(it->itemId);
+            forgetItem(itemHandle(meta.id, it->itemId));
+            it = known.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QList<QSharedPointer<CalendarItem>> added;
+    QList<QSharedPointer<CalendarItem>> updated;
+    for (const LoadedItem &entry : buildItems(meta.id, parseIcsFiles(changedPaths, nullptr, m_lazyLoading), m_hashAlgorithm, m_lazyLoading)) {
+        const QString itemId = entry.item->id();
+        const FileState previous = known.value(entry.filePath);
+        const QString previousVersion = m_idToVersion.value(entry.item->handle());
+        if (!previous.itemId.isEmpty() && previous.itemId != itemId) {
+            // Same file now holds a different UID
+            removedIds.append(previous.itemId);
+            forgetItem(itemHandle(meta.id, previous.itemId));
+        }
+        recordLoadedFile(entry);
+        if (m_watcher) {
+            m_watcher->addPath(entry.filePath); // Atomic replace drops the old watch
+        }
+
+        if (previous.itemId != itemId) {
+            added.append(entry.item);
+        } else if (previousVersion != entry.item->versionIdentifier()) {
+            updated.append(entry.item);
+        } // else: touched but byte-identical
+    }
+    // Files that failed to parse keep their old item; the next write to them triggers another rescan
+
+    qDebug() << "LocalBackend: Rescanned" << dirPath << "-" << added.size() << "added," << updated.size()
+             << "updated," << removedIds.size() << "removed";
+    if (!added.isEmpty()) emit itemsAdded(meta.id, added);
+    if (!updated.isEmpty()) emit itemsUpdated(meta.id, updated);
+    if (!removedIds.isEmpty()) emit itemsRemoved(meta.id, removedIds);
+}
+
+void LocalBackend::beginCommit()
+{
+    if (m_commit) {
+        qWarning() << "LocalBackend: Commit already open for" << m_rootPath;
+        return;
+    }
+    m_commit.reset(new GroupCommitWriter(m_writeDurability));
+    m_stagedWrites.clear();
+    m_elidedWrites = 0;
+}
+
+bool LocalBackend::isCurrentFile(IdTable::Id handle, const QString &filePath) const
+{
+    return m_idToPath.value(handle) == filePath && QFileInfo::exists(filePath);
+}
+
+IdTable::Id LocalBackend::itemHandle(const QString &calId, const QString &itemId)
+{
+    return IdTable::findItem(IdTable::calendar(calId), itemId); // 0, found nowhere, for ids never loaded
+}
+
+void LocalBackend::forgetItem(IdTable::Id handle)
+{
+    m_idToPath.remove(handle);
+    m_idToVersion.remove(handle);
+    m_idToRevision.remove(handle);
+}
+
+void LocalBackend::stageWrite(IdTable::Id handle, const QString &itemId, const QString &filePath, const QByteArray &data,
+                              quint64 revision)
+{
+    // Byte-identical to what is on disk (e.g. an edit that was reverted): nothing to write
+    const QString versionIdentifier = ContentHash::versionIdentifier(data, m_hashAlgorithm);
+    if (m_idToVersion.value(handle) == versionIdentifier && isCurrentFile(handle, filePath)) {
+        if (revision) m_idToRevision[handle] = revision;
+        ++m_elidedWrites;
+        return;
+    }
+
+    QString error;
+    if (!m_commit->stage(filePath, data, &error)) {
+        emit errorOccurred("Failed to write item: " + error);
+        return;
+    }
+    m_stagedWrites.append({handle, itemId, filePath, versionIdentifier, revision});
+}
+
+void LocalBackend::endCommit()
+{
+    if (!m_commit) {
+        return;
+    }
+    m_lastCommitResult = m_commit->commit();
+    m_lastCommitElided = m_elidedWrites;
+    m_commit.reset();
+
+    // Only files that actually replaced their target get new bookkeeping
+    const QSet<QString> written(m_lastCommitResult.writtenPaths.cbegin(), m_lastCommitResult.writtenPaths.cend());
+    for (const StagedWrite &staged : std::as_const(m_stagedWrites)) {
+        if (!written.contains(staged.filePath)) continue;
+        m_idToPath[staged.handle] = staged.filePath;
+        m_idToVersion[staged.handle] = staged.versionIdentifier;
+        if (staged.revision) {
+            m_idToRevision[staged.handle] = staged.revision;
+        } else {
+            m_idToRevision.remove(staged.handle); // Written from raw data; the item's revision is unknown
+        }
+        recordWrittenFile(staged.filePath, staged.itemId);
+    }
+    m_stagedWrites.clear();
+
+    if (m_lastCommitResult.failed > 0) {
+        emit errorOccurred(QString("Failed to commit %1 of %2 items: %3")
+                               .arg(m_lastCommitResult.failed)
+                               .arg(m_lastCommitResult.failed + m_lastCommitResult.written)
+                               .arg(m_lastCommitResult.errorString));
+    }
+    qDebug() << "LocalBackend: Committed" << m_lastCommitResult.written << "files under" << m_rootPath
+             << "-" << m_lastCommitElided << "unchanged items not rewritten";
+}
@@ -2,16 +2,36 @@
 #define LOCALBACKEND_H
 
 #include "syncbackend.h"
+#include "contenthash.h"
+#include "snapshotcache.h"
+#include "icsheaderscanner.h"
+#include "groupcommitwriter.h"
+#include "idtable.h"
 #include <QDir>
 #include <QMap>
 #include <QSharedPointer>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <atomic>
+#include <memory>
+
+class QThread;
+class QTimer;
+class QFileSystemWatcher;
 
 class LocalBackend : public SyncBackend
 {
     Q_OBJECT
     Q_PROPERTY(QString rootPath READ rootPath)
+    Q_PROPERTY(int loadWorkerCount READ loadWorkerCount WRITE setLoadWorkerCount)
+    Q_PROPERTY(int syncBatchSize READ syncBatchSize WRITE setSyncBatchSize)
+    Q_PROPERTY(bool watchEnabled READ isWatchEnabled WRITE setWatchEnabled)
+    Q_PROPERTY(bool lazyLoading READ lazyLoading WRITE setLazyLoading)
 public:
     explicit LocalBackend(const QString &rootPath, QObject *parent = nullptr);
+    ~LocalBackend() override;
 
     QString rootPath() const { return m_rootPath; }
     QList<CalendarMetadata> loadCalendars(const QString &collectionId) override;
@@ -26,9 +46,163 @@ public:
     QString fetchItemVersionIdentifier(const QString &calId, const QString &itemId) override;
     void removeItem(const QString &calId, const QString &itemId) override;
 
+    // Writes between these go to temp files and are renamed into place together; without them
+    // each storeItems/updateItem call is its own group
+    void beginCommit() override;
+    void endCommit() override;
+    GroupCommitWriter::Durability writeDurability() const { return m_writeDurability; }
+    void setWriteDurability(GroupCommitWriter::Durability durability) { m_writeDurability = durability; }
+    GroupCommitWriter::Result lastCommitResult() const { return m_lastCommitResult; }
+    int lastCommitElided() const { return m_lastCommitElided; } // Items skipped because the file already matched
+
+    // Number of threads used to read and parse .ics files; 0 means QThread::idealThreadCount(), 1 parses on the calling thread
+    int loadWorkerCount() const { return m_loadWorkerCount; }
+    void setLoadWorkerCount(int count);
+
+    // Hash used for version identifiers; computed from the bytes read during parsing
+    ContentHash::Algorithm hashAlgorithm() const { return m_hashAlgorithm; }
+    void setHashAlgorithm(ContentHash::Algorithm algorithm);
+
+    // Binary cache of parsed files consulted by startSync; empty disables it
+    QString snapshotPath() const { return m_snapshotPath; }
+    void setSnapshotPath(const QString &path);
+    int lastSyncSnapshotHits() const { return m_lastSyncSnapshotHits; }
+
+    // Items per itemsLoaded signal emitted by startSync
+    int syncBatchSize() const { return m_syncBatchSize; }
+    void setSyncBatchSize(int size);
+
+    // Keep only each item's header after loading; the incidence is re-read from its file on first use
+    bool lazyLoading() const { return m_lazyLoading; }
+    void setLazyLoading(bool lazy) { m_lazyLoading = lazy; }
+
+    // Streams a VCALENDAR file of any size into the calendar on a worker thread, syncBatchSize items per
+    // itemsAdded signal. With explode every item is also written to its own file in the calendar directory;
+    // otherwise the items arrive dirty and reach disk with the next commit. Ends with importFinished.
+    bool importIcsFile(const QString &sourcePath, const CalendarMetadata &calendar, bool explode);
+    bool isImporting() const { return m_importThread; }
+    void cancelImport();
+
+    // Watch calendar directories for external edits and emit itemsAdded/Updated/Removed.
+    // Takes effect for calendars discovered by startSync; bursts are coalesced over the debounce interval.
+    bool isWatchEnabled() const { return m_watchEnabled; }
+    void setWatchEnabled(bool enabled);
+    int watchDebounceInterval() const;
+    void setWatchDebounceInterval(int msecs);
+
+signals:
+    void importProgress(const QString &calId, qint64 bytesRead, qint64 totalBytes);
+    void importFinished(const QString &calId, int imported, int failed);
+
+private slots:
+    void onWatchedPathChanged(const QString &path);
+    void processWatchedChanges();
+
 private:
+    // Result of reading and parsing a single .ics file; safe to produce on a worker thread
+    struct ParsedIcsFile {
+        QString filePath;
+        KCalendarCore::Incidence::Ptr incidence; // Null if the file could not be used or only its header was read
+        IcsHeaderScanner::Header header;         // Set instead of incidence when headerOnly
+        QDateTime lastModified;
+        qint64 size = -1;
+        QString versionIdentifier; // Hash of the bytes that were parsed
+        bool fromSnapshot = false;
+        QString snapshotKey;
+        SnapshotCache::Entry snapshotEntry; // Filled only when a snapshot is being recorded
+        bool headerOnly = false;
+        bool uidDerived = false; // Import only: the UID was generated, so the parsed bytes lack it
+
+        bool isValid() const { return incidence || headerOnly; }
+    };
+
+    struct LoadedItem {
+        QSharedPointer<CalendarItem> item;
+        QString filePath;
+        QDateTime fileModified;
+        qint64 fileSize = -1;
+    };
+
+    // What we last saw of a file, so a rescan can tell external edits from our own writes
+    struct FileState {
+        qint64 mtime = 0;
+        qint64 size = -1;
+        QString itemId;
+    };
+
+    // headerOnly tries IcsHeaderScanner first and falls back to the full parser when it declines
+    static ParsedIcsFile parseIcsFile(const QString &filePath, ContentHash::Algorithm algorithm, bool headerOnly = false);
+    static ParsedIcsFile parseIcsData(const QString &filePath, const QByteArray &rawData,
+                                      ContentHash::Algorithm algorithm, bool headerOnly);
+    static QString itemUidFor(const KCalendarCore::Incidence::Ptr &incidence);
+    static ParsedIcsFile loadIcsFile(const QString &filePath, const QString &snapshotKey,
+                                     ContentHash::Algorithm algorithm, const SnapshotCache *snapshot, bool headerOnly);
+    QList<ParsedIcsFile> parseIcsFiles(const QStringList &filePaths, const SnapshotCache *snapshot = nullptr,
+                                       bool headerOnly = false);
+    int effectiveLoadWorkerCount() const;
+    QStringList icsFilePaths(const QString &calName) const;
+    static QList<LoadedItem> buildItems(const QString &calId, const QList<ParsedIcsFile> &parsedFiles,
+                                        ContentHash::Algorithm algorithm, bool lazy);
+
+    // Run on the GUI thread, posted from the sync thread
+    void deliverItemBatch(const QString &calId, const QList<LoadedItem> &batch);
+    void finishCalendar(const QString &calId);
+    void finishSync(const QString &collectionId, int snapshotHits);
+    void stopSyncThread();
+    void deliverImportBatch(const QString &calId, const QList<LoadedItem> &batch, bool explode);
+    void finishImport(const QString &calId, int imported, int failed);
+    void stopImportThread();
+
+    // A write staged in the current group; bookkeeping is applied once it has been renamed into place
+    struct StagedWrite {
+        IdTable::Id handle;
+        QString itemId;
+        QString filePath;
+        QString versionIdentifier;
+        quint64 revision = 0; // CalendarItem::revision() that was serialized; 0 for raw data
+    };
+    void stageWrite(IdTable::Id handle, const QString &itemId, const QString &filePath, const QByteArray &data,
+                    quint64 revision);
+    bool isCurrentFile(IdTable::Id handle, const QString &filePath) const;
+    static IdTable::Id itemHandle(const QString &calId, const QString &itemId);
+    void forgetItem(IdTable::Id handle);
+
+    void recordLoadedFile(const LoadedItem &entry);
+    void recordWrittenFile(const QString &filePath, const QString &itemId);
+    void forgetFile(const QString &filePath);
+    void startWatching();
+    void rescanDirectory(const QString &dirPath);
+
     QString m_rootPath;
-    QMap<QString, QString> m_idToPath; // Retained for storage/update
+    // Keyed by CalendarItem::handle(), so the same UID in two calendars never shares an entry
+    QHash<IdTable::Id, QString> m_idToPath; // Retained for storage/update
+    QHash<IdTable::Id, QString> m_idToVersion; // Hash of each file as last read or written by us
+    QHash<IdTable::Id, quint64> m_idToRevision; // Item revision that matches that file content
+    ContentHash::Algorithm m_hashAlgorithm = ContentHash::Algorithm::Md5;
+    int m_loadWorkerCount = 0;
+    QThreadPool m_loadPool; // Private pool so parsing never starves QThreadPool::globalInstance()
+    int m_syncBatchSize = 500;
+    bool m_lazyLoading = false;
+    GroupCommitWriter::Durability m_writeDurability = GroupCommitWriter::Durability::GroupSync;
+    std::unique_ptr<GroupCommitWriter> m_commit; // Open group, if any
+    QList<StagedWrite> m_stagedWrites;
+    GroupCommitWriter::Result m_lastCommitResult;
+    int m_elidedWrites = 0;
+    int m_lastCommitElided = 0;
+    QString m_snapshotPath;
+    int m_lastSyncSnapshotHits = 0;
+    QThread *m_syncThread = nullptr;
+    std::atomic<bool> m_syncCancelled{false};
+    QMap<QString, Cal*> m_syncCals; // Temporary Cal objects handed out in signals during sync
+    QThread *m_importThread = nullptr;
+    std::atomic<bool> m_importCancelled{false};
+
+    bool m_watchEnabled = false;
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_watchTimer = nullptr;
+    QSet<QString> m_pendingDirs;
+    QHash<QString, CalendarMetadata> m_calDirs; // Calendar directory path -> calendar
+    QHash<QString, QHash<QString, FileState>> m_fileState; // Calendar directory path -> file path -> state
 };
 
 #endif // LOCALBACKEND_H
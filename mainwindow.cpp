@@ -120,6 +120,16 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->actionOpenCollection, &QAction::triggered, this, &MainWindow::onOpenCollection);
     connect(ui->actionAddLocalBackend, &QAction::triggered, this, &MainWindow::onAddLocalBackend);
     connect(ui->actionCommitChanges, &QAction::triggered, this, &MainWindow::onCommitChanges);
+    connect(ui->actionImportIcs, &QAction::triggered, this, &MainWindow::onImportIcs);
+    connect(collectionController, &CollectionController::importProgress, this,
+            [currentProgressBar](const QString &, qint64 bytesRead, qint64 totalBytes) {
+                currentProgressBar->setValue(totalBytes > 0 ? int(bytesRead * 100 / totalBytes) : 0);
+            });
+    connect(collectionController, &CollectionController::importFinished, this,
+            [this, currentProgressBar](const QString &calId, int imported, int failed) {
+                currentProgressBar->setValue(100);
+                ui->logTextEdit->append(QString("Imported %1 items into %2 (%3 failed)").arg(imported).arg(calId).arg(failed));
+            });
     connect(ui->actionCloseCollection, &QAction::triggered, this, &MainWindow::onCloseCollection); // Updated
 
     // Connect CalendarTableView selections dynamically
@@ -326,6 +336,31 @@ void MainWindow::onAddLocalBackend()
     ui->logTextEdit->append("Local backend added at " + dir);
 }
 
+void MainWindow::onImportIcs()
+{
+    if (!activeCollection || activeCal.isEmpty()) {
+        ui->logTextEdit->append("Select a calendar to import into");
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, tr("Import .ics File"), QDir::currentPath(), tr("iCalendar Files (*.ics)"));
+    if (filePath.isEmpty()) {
+        ui->logTextEdit->append("Import canceled");
+        return;
+    }
+    QMessageBox::StandardButton reply = QMessageBox::question(
+        this,
+        tr("Import .ics File"),
+        tr("Write every imported item to its own file in the local backend now?\n"
+           "Otherwise the items are added as uncommitted changes."),
+        QMessageBox::Yes | QMessageBox::No
+        );
+    if (!collectionController->importIcsFile(activeCollection->id(), activeCal, filePath, reply == QMessageBox::Yes)) {
+        ui->logTextEdit->append("Cannot import " + filePath + ": the collection needs a local backend and no other import may be running");
+        return;
+    }
+    ui->logTextEdit->append("Importing " + filePath + " into " + activeCal);
+}
 
 void MainWindow::onSelectionChanged()
 {
@@ -598,6 +633,7 @@ void MainWindow::onCommitChanges()
     const QMap<QString, QList<SyncBackend*>> &backends = collectionController->backends();
     const QList<SyncBackend*> &collectionBackends = backends.value(activeCollection->id());
     for (SyncBackend *backend : collectionBackends) {
+        backend->beginCommit(); // One durable group per backend for the whole commit
         for (const QString &calId : itemsToCommit.keys()) {
             Cal *cal = collectionController->getCal(calId);
             if (cal) {
@@ -608,6 +644,13 @@ void MainWindow::onCommitChanges()
                 }
             }
         }
+        backend->endCommit();
+        if (LocalBackend *local = qobject_cast<LocalBackend*>(backend)) {
+            const GroupCommitWriter::Result result = local->lastCommitResult();
+            ui->logTextEdit->append(QString("Wrote %1 files to %2 (%3 unchanged skipped, %4 failed)")
+                                        .arg(result.written).arg(local->rootPath())
+                                        .arg(local->lastCommitElided()).arg(result.failed));
+        }
     }
 
     ui->logTextEdit->append("Committed staged changes to backends");
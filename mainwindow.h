@@ -48,6 +48,7 @@ private slots:
 
     void onSelectionChanged(); // New slot
     void onCommitChanges(); // New slot
+    void onImportIcs();
 
     void onCalendarAdded(Cal *cal); // New slot
     void onAllSyncsCompleted(const QString &collectionId); // New slot
@@ -0,0 +1,426 @@
+#include "mergedcalendarmodel.h"
+#include "cal.h"
+#include "collection.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+// Larger changes are reported as one reset; a signal per row would cost views more than relayouting
+constexpr int IncrementalLimit = 64;
+}
+
+MergedCalendarModel::MergedCalendarModel(Collection *collection, QObject *parent)
+    : QAbstractTableModel(parent), m_collection(collection), m_checkedRevision(CalendarItem::latestRevision())
+{
+    m_catchUpTimer.setSingleShot(true);
+    m_catchUpTimer.setInterval(0);
+    connect(&m_catchUpTimer, &QTimer::timeout, this, &MergedCalendarModel::catchUp);
+    connect(m_collection, &Collection::calendarsChanged, this, &MergedCalendarModel::syncCalendars);
+    syncCalendars();
+}
+
+void MergedCalendarModel::syncCalendars()
+{
+    beginResetModel();
+    // Calendars still in the collection keep their sorted runs; only new ones are sorted
+    QList<Run> runs;
+    const QList<Cal*> calendars = m_collection->calendars();
+    for (Cal *cal : calendars) {
+        const int existing = runOf(cal);
+        if (existing >= 0) {
+            runs.append(std::move(m_runs[existing]));
+            m_runs[existing].cal = nullptr;
+            continue;
+        }
+        attach(cal);
+        Run run;
+        run.cal = cal;
+        buildRun(run);
+        runs.append(std::move(run));
+    }
+    for (const Run &run : std::as_const(m_runs)) {
+        if (run.cal) disconnect(run.cal, nullptr, this, nullptr);
+    }
+    m_runs = std::move(runs);
+    m_total = 0;
+    for (const Run &run : std::as_const(m_runs)) {
+        m_total += run.entries.size();
+    }
+    restartMerge();
+    endResetModel();
+    qDebug() << "MergedCalendarModel: Merging" << m_runs.size() << "calendars of" << m_collection->id()
+             << "-" << m_total << "rows";
+}
+
+void MergedCalendarModel::attach(Cal *cal)
+{
+    connect(cal, &QAbstractItemModel::rowsInserted, this,
+            [this, cal](const QModelIndex &, int first, int last) { calRowsInserted(cal, first, last); });
+    connect(cal, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this, cal](const QModelIndex &, int first, int last) { calRowsAboutToBeRemoved(cal, first, last); });
+    connect(cal, &QAbstractItemModel::rowsRemoved, this, [this, cal] { calResetDone(cal); });
+    connect(cal, &QAbstractItemModel::dataChanged, this,
+            [this, cal](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                calDataChanged(cal, topLeft.row(), bottomRight.row());
+            });
+    connect(cal, &QAbstractItemModel::modelAboutToBeReset, this, [this] { calAboutToBeReset(); });
+    connect(cal, &QAbstractItemModel::modelReset, this, [this, cal] { calResetDone(cal); });
+    connect(cal, &QObject::destroyed, this, [this](QObject *object) { detach(object); });
+}
+
+void MergedCalendarModel::detach(QObject *cal)
+{
+    // The calendar is being destroyed; nothing of it may be read any more
+    const int run = runOf(cal);
+    if (run < 0) return;
+    beginResetModel();
+    m_total -= m_runs.at(run).entries.size();
+    m_runs.removeAt(run);
+    restartMerge();
+    endResetModel();
+}
+
+void MergedCalendarModel::buildRun(Run &run)
+{
+    const int rows = run.cal->rowCount();
+    run.entries.clear();
+    run.entries.reserve(rows);
+    run.startOf.clear();
+    run.startOf.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        const Entry entry = entryFor(run.cal, row);
+        run.entries.append(entry);
+        run.startOf.insert(entry.handle, entry.start);
+    }
+    std::sort(run.entries.begin(), run.entries.end(), entryLess);
+}
+
+int MergedCalendarModel::runOf(const QObject *cal) const
+{
+    for (int run = 0; run < m_runs.size(); ++run) {
+        if (m_runs.at(run).cal == cal) return run;
+    }
+    return -1;
+}
+
+MergedCalendarModel::Entry MergedCalendarModel::entryFor(const Cal *cal, int row)
+{
+    // Straight from the item: going through Cal::data() would format the whole display row
+    return {startKey(*cal->itemAt(row)), cal->handleAt(row)};
+}
+
+qint64 MergedCalendarModel::startKey(const CalendarItem &item)
+{
+    const QDateTime start = item.dtStart();
+    return start.isValid() ? start.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+}
+
+bool MergedCalendarModel::entryLess(const Entry &a, const Entry &b)
+{
+    return a.start != b.start ? a.start < b.start : a.handle < b.handle;
+}
+
+int MergedCalendarModel::rankOf(int run, const Entry &entry) const
+{
+    // Sum of each run's share of the rows before the entry: O(k log n) without merging anything
+    auto byStart = [](const Entry &a, const Entry &b) { return a.start < b.start; };
+    int rank = 0;
+    for (int other = 0; other < m_runs.size(); ++other) {
+        const QList<Entry> &entries = m_runs.at(other).entries;
+        if (other == run) {
+            rank += std::lower_bound(entries.cbegin(), entries.cend(), entry, entryLess) - entries.cbegin();
+        } else if (other < run) {
+            rank += std::upper_bound(entries.cbegin(), entries.cend(), entry, byStart) - entries.cbegin();
+        } else {
+            rank += std::lower_bound(entries.cbegin(), entries.cend(), entry, byStart) - entries.cbegin();
+        }
+    }
+    return rank;
+}
+
+void MergedCalendarModel::insertEntry(int run, const Entry &entry, int rank)
+{
+    truncate(rank);
+    Run &target = m_runs[run];
+    const auto it = std::lower_bound(target.entries.cbegin(), target.entries.cend(), entry, entryLess);
+    target.entries.insert(it - target.entries.cbegin(), entry);
+    target.startOf.insert(entry.handle, entry.start);
+    ++m_total;
+}
+
+void MergedCalendarModel::removeEntry(int run, const Entry &entry, int rank)
+{
+    truncate(rank);
+    Run &target = m_runs[run];
+    const auto it = std::lower_bound(target.entries.cbegin(), target.entries.cend(), entry, entryLess);
+    if (it == target.entries.cend() || it->handle != entry.handle) return;
+    target.entries.removeAt(it - target.entries.cbegin());
+    target.startOf.remove(entry.handle);
+    --m_total;
+}
+
+void MergedCalendarModel::truncate(int rank)
+{
+    // Rows before rank are unaffected by a change at rank; the cursors step back over the dropped ones
+    for (int row = rank; row < m_merged.size(); ++row) {
+        --m_cursor[m_merged.at(row).run];
+    }
+    if (rank < m_merged.size()) {
+        m_merged.resize(rank);
+    }
+    m_heapValid = false; // The entry under a cursor may be the one that changes
+}
+
+void MergedCalendarModel::restartMerge()
+{
+    m_merged.clear();
+    m_cursor.fill(0, m_runs.size());
+    m_heapValid = false;
+}
+
+void MergedCalendarModel::ensureMerged(int rows) const
+{
+    if (m_merged.size() >= rows) return;
+    // Min-heap on each run's next entry; equal starts go to the earlier calendar, as in rankOf()
+    auto later = [this](int a, int b) {
+        const qint64 startA = m_runs.at(a).entries.at(m_cursor.at(a)).start;
+        const qint64 startB = m_runs.at(b).entries.at(m_cursor.at(b)).start;
+        return startA != startB ? startA > startB : a > b;
+    };
+    if (!m_heapValid) {
+        m_heap.clear();
+        for (int run = 0; run < m_runs.size(); ++run) {
+            if (m_cursor.at(run) < m_runs.at(run).entries.size()) m_heap.append(run);
+        }
+        std::make_heap(m_heap.begin(), m_heap.end(), later);
+        m_heapValid = true;
+    }
+    m_merged.reserve(rows);
+    while (m_merged.size() < rows && !m_heap.isEmpty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        const int run = m_heap.last();
+        m_merged.append({run, m_cursor[run]++});
+        if (m_cursor.at(run) < m_runs.at(run).entries.size()) {
+            std::push_heap(m_heap.begin(), m_heap.end(), later);
+        } else {
+            m_heap.removeLast();
+        }
+    }
+}
+
+void MergedCalendarModel::calRowsInserted(Cal *cal, int first, int last)
+{
+    const int run = runOf(cal);
+    if (run < 0) return;
+    if (last - first + 1 > IncrementalLimit) {
+        // A loaded batch: sort just the new rows and merge them into this calendar's run
+        beginResetModel();
+        Run &target = m_runs[run];
+        const qsizetype middle = target.entries.size();
+        for (int row = first; row <= last; ++row) {
+            const Entry entry = entryFor(cal, row);
+            target.entries.append(entry);
+            target.startOf.insert(entry.handle, entry.start);
+        }
+        std::sort(target.entries.begin() + middle, target.entries.end(), entryLess);
+        std::inplace_merge(target.entries.begin(), target.entries.begin() + middle, target.entries.end(), entryLess);
+        m_total += last - first + 1;
+        restartMerge();
+        endResetModel();
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Entry entry = entryFor(cal, row);
+        const int rank = rankOf(run, entry);
+        beginInsertRows(QModelIndex(), rank, rank);
+        insertEntry(run, entry, rank);
+        endInsertRows();
+    }
+}
+
+void MergedCalendarModel::calRowsAboutToBeRemoved(Cal *cal, int first, int last)
+{
+    const int run = runOf(cal);
+    if (run < 0) return;
+    if (last - first + 1 > IncrementalLimit) {
+        beginResetModel();
+        m_resetPending = true; // Finished in calResetDone() once the rows are gone
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const IdTable::Id handle = cal->handleAt(row);
+        const Entry entry{m_runs.at(run).startOf.value(handle), handle};
+        const int rank = rankOf(run, entry);
+        beginRemoveRows(QModelIndex(), rank, rank);
+        removeEntry(run, entry, rank);
+        endRemoveRows();
+    }
+}
+
+void MergedCalendarModel::calDataChanged(Cal *cal, int first, int last)
+{
+    const int run = runOf(cal);
+    if (run < 0) return;
+    if (last - first + 1 > IncrementalLimit) {
+        rebuildRun(run);
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Entry entry = entryFor(cal, row);
+        const auto old = m_runs.at(run).startOf.constFind(entry.handle);
+        if (old == m_runs.at(run).startOf.constEnd()) continue;
+        const Entry before{old.value(), entry.handle};
+        const int from = rankOf(run, before);
+        int to = from;
+        if (before.start != entry.start) {
+            const int destination = rankOf(run, entry); // Counts the entry at its old place if it moves down
+            const bool moves = destination != from && destination != from + 1;
+            if (moves) beginMoveRows(QModelIndex(), from, from, QModelIndex(), destination);
+            removeEntry(run, before, from);
+            to = destination > from ? destination - 1 : destination;
+            insertEntry(run, entry, to);
+            if (moves) endMoveRows();
+        }
+        emit dataChanged(index(to, 0), index(to, columnCount() - 1));
+    }
+}
+
+void MergedCalendarModel::rebuildRun(int run)
+{
+    beginResetModel();
+    m_total -= m_runs.at(run).entries.size();
+    buildRun(m_runs[run]);
+    m_total += m_runs.at(run).entries.size();
+    restartMerge();
+    endResetModel();
+}
+
+void MergedCalendarModel::scheduleCatchUp() const
+{
+    if (CalendarItem::latestRevision() != m_checkedRevision && !m_catchUpTimer.isActive()) {
+        m_catchUpTimer.start();
+    }
+}
+
+void MergedCalendarModel::catchUp()
+{
+    // Items edited in place since the last check: any revision above it. Changes already reported by
+    // the calendars' signals are in their runs, so only a start that differs from the run's moves a row.
+    m_catchUpTimer.stop();
+    const quint64 latest = CalendarItem::latestRevision();
+    if (latest == m_checkedRevision) return;
+    const quint64 checked = std::exchange(m_checkedRevision, latest);
+    bool edited = false;
+    for (int run = 0; run < m_runs.size(); ++run) {
+        Cal *cal = m_runs.at(run).cal;
+        const QList<QSharedPointer<CalendarItem>> items = cal->items();
+        QList<int> moved;
+        for (int row = 0; row < items.size(); ++row) {
+            const CalendarItem &item = *items.at(row);
+            if (item.revision() <= checked) continue;
+            edited = true;
+            if (m_runs.at(run).startOf.value(cal->handleAt(row)) != startKey(item)) moved.append(row);
+        }
+        if (moved.size() > IncrementalLimit) {
+            rebuildRun(run);
+            continue;
+        }
+        for (int row : std::as_const(moved)) {
+            calDataChanged(cal, row, row);
+        }
+    }
+    if (edited && m_total > 0) {
+        emit dataChanged(index(0, 0), index(m_total - 1, columnCount() - 1)); // Summaries and the like, too
+    }
+}
+
+void MergedCalendarModel::calAboutToBeReset()
+{
+    if (m_resetPending) return;
+    beginResetModel();
+    m_resetPending = true;
+}
+
+void MergedCalendarModel::calResetDone(Cal *cal)
+{
+    if (!m_resetPending) return; // Removals handled row by row are already applied
+    m_resetPending = false;
+    const int run = runOf(cal);
+    if (run >= 0) {
+        m_total -= m_runs.at(run).entries.size();
+        buildRun(m_runs[run]);
+        m_total += m_runs.at(run).entries.size();
+    }
+    restartMerge();
+    endResetModel();
+}
+
+QSharedPointer<CalendarItem> MergedCalendarModel::itemAt(int row) const
+{
+    scheduleCatchUp();
+    if (row < 0 || row >= m_total) return QSharedPointer<CalendarItem>();
+    ensureMerged(row + 1);
+    const Ref ref = m_merged.at(row);
+    const Cal *cal = m_runs.at(ref.run).cal;
+    return cal->itemAt(cal->rowOf(entryAt(ref).handle));
+}
+
+Cal *MergedCalendarModel::calendarAt(int row) const
+{
+    scheduleCatchUp();
+    if (row < 0 || row >= m_total) return nullptr;
+    ensureMerged(row + 1);
+    return m_runs.at(m_merged.at(row).run).cal;
+}
+
+int MergedCalendarModel::rowOf(const Cal *cal, IdTable::Id itemHandle) const
+{
+    scheduleCatchUp();
+    const int run = runOf(cal);
+    if (run < 0) return -1;
+    const auto start = m_runs.at(run).startOf.constFind(itemHandle);
+    if (start == m_runs.at(run).startOf.constEnd()) return -1;
+    return rankOf(run, {start.value(), itemHandle});
+}
+
+int MergedCalendarModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_total;
+}
+
+int MergedCalendarModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return CalendarColumn + 1; // Type, Summary, Start, End/Due, Calendar
+}
+
+QVariant MergedCalendarModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_total || index.column() >= columnCount()) return QVariant();
+    scheduleCatchUp();
+    ensureMerged(index.row() + 1);
+    const Ref ref = m_merged.at(index.row());
+    const Cal *cal = m_runs.at(ref.run).cal;
+    if (index.column() == CalendarColumn) {
+        if (role == Qt::DisplayRole) return cal->name();
+        if (role == Cal::SortRole) return cal->name().toCaseFolded();
+        return QVariant();
+    }
+    return cal->data(cal->index(cal->rowOf(entryAt(ref).handle), index.column()), role);
+}
+
+QVariant MergedCalendarModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section) {
+    case 0: return "Type";
+    case 1: return "Summary";
+    case 2: return "Start";
+    case 3: return "End/Due";
+    case CalendarColumn: return "Calendar";
+    default: return QVariant();
+    }
+}
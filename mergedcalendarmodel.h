@@ -0,0 +1,99 @@
+#ifndef MERGEDCALENDARMODEL_H
+#define MERGEDCALENDARMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QTimer>
+#include "idtable.h"
+
+class Cal;
+class CalendarItem;
+class Collection;
+
+// Every calendar of a Collection as one table ordered by start (Cal::SortRole of the Start column).
+// Each calendar keeps its own sorted run of (start, item handle); rows are produced by a k-way merge of
+// the runs, only as far down as a view has asked for. A change in one calendar moves, inserts or removes
+// the affected rows in its run and discards the merged rows from that point on; nothing else is re-sorted.
+// Items edited in place emit no signal; reading the model schedules a catch-up by revision for the next
+// event loop pass, so rows never move while a view is painting them.
+class MergedCalendarModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        CalendarColumn = 4 // After the columns of Cal, which keep their positions
+    };
+
+    explicit MergedCalendarModel(Collection *collection, QObject *parent = nullptr);
+
+    QSharedPointer<CalendarItem> itemAt(int row) const;
+    Cal *calendarAt(int row) const;
+    int rowOf(const Cal *cal, IdTable::Id itemHandle) const; // -1 when the item is not shown
+    int mergedRows() const { return m_merged.size(); } // Rows merged so far; the rest are merged on demand
+    void catchUp(); // Applies in-place edits now instead of on the next event loop pass
+
+    // QAbstractTableModel
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Entry {
+        qint64 start;
+        IdTable::Id handle;
+    };
+    // One calendar's items, sorted by (start, handle)
+    struct Run {
+        Cal *cal = nullptr;
+        QList<Entry> entries;
+        QHash<IdTable::Id, qint64> startOf; // Start each entry was sorted under, to find it after an edit
+    };
+    struct Ref {
+        int run;
+        int pos;
+    };
+
+    void syncCalendars();
+    void attach(Cal *cal);
+    void detach(QObject *cal);
+    void buildRun(Run &run);
+    int runOf(const QObject *cal) const;
+    static Entry entryFor(const Cal *cal, int row);
+    static qint64 startKey(const CalendarItem &item); // Same key as Cal::SortRole of the Start column
+    static bool entryLess(const Entry &a, const Entry &b);
+
+    // Rows before the entry in the merged order, whether or not they have been merged yet
+    int rankOf(int run, const Entry &entry) const;
+    void insertEntry(int run, const Entry &entry, int rank);
+    void removeEntry(int run, const Entry &entry, int rank);
+    void truncate(int rank);
+    void restartMerge();
+    void ensureMerged(int rows) const;
+    void rebuildRun(int run); // Re-sorts one calendar's run behind a model reset
+    void scheduleCatchUp() const;
+    const Entry &entryAt(const Ref &ref) const { return m_runs.at(ref.run).entries.at(ref.pos); }
+
+    // Handlers for the calendars' model signals
+    void calRowsInserted(Cal *cal, int first, int last);
+    void calRowsAboutToBeRemoved(Cal *cal, int first, int last);
+    void calDataChanged(Cal *cal, int first, int last);
+    void calAboutToBeReset();
+    void calResetDone(Cal *cal); // Rebuilds the calendar's run after a change reported as a reset
+
+    Collection *m_collection;
+    QList<Run> m_runs; // In collection order; the run index breaks ties between equal starts
+    int m_total = 0;
+    bool m_resetPending = false; // A calendar change is being reported as a reset
+    mutable QList<Ref> m_merged; // Merged prefix
+    mutable QList<int> m_cursor; // Per run: entries already in m_merged
+    mutable QList<int> m_heap; // Runs with entries left, as a min-heap on their next entry
+    mutable bool m_heapValid = false;
+    quint64 m_checkedRevision = 0; // CalendarItem::latestRevision() at the last catch-up
+    mutable QTimer m_catchUpTimer;
+};
+
+#endif // MERGEDCALENDARMODEL_H
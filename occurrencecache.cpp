@@ -0,0 +1,100 @@
+#include "occurrencecache.h"
+#include <KCalendarCore/Recurrence>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+constexpr qint64 dayMSecs = 24 * 60 * 60 * 1000;
+}
+
+const OccurrenceCache::Entry &OccurrenceCache::entryFor(const CalendarItem &series, const QDateTime &from, const QDateTime &to)
+{
+    Entry &entry = m_entries[series.handle()];
+    if (entry.revision == series.revision() && entry.from <= from && entry.to >= to) {
+        return entry;
+    }
+
+    QDateTime windowFrom = from;
+    QDateTime windowTo = to;
+    if (entry.revision == series.revision() && entry.from.isValid()) {
+        // Paging forwards or backwards: grow the cached window when the new one touches it
+        const qint64 span = from.msecsTo(to);
+        if (from <= entry.to.addMSecs(span) && to >= entry.from.addMSecs(-span)) {
+            windowFrom = qMin(from, entry.from);
+            windowTo = qMax(to, entry.to);
+        }
+    }
+
+    const QSharedPointer<const KCalendarCore::Incidence> incidence = series.incidence();
+    entry = Entry();
+    entry.revision = series.revision();
+    entry.from = windowFrom;
+    entry.to = windowTo;
+    if (!incidence || !incidence->recurs()) {
+        return entry;
+    }
+    QDateTime start = series.dtStart();
+    const QDateTime end = series.dtEndOrDue();
+    if (!start.isValid()) start = end;
+    entry.duration = start.isValid() && end.isValid() && end > start ? start.msecsTo(end) : 0;
+    entry.reach = qMax<qint64>(entry.duration + (series.allDay() ? dayMSecs : 0), 1);
+
+    // Instances that started before the window but are still running overlap it too
+    const QList<QDateTime> times = incidence->recurrence()->timesInInterval(windowFrom.addMSecs(-entry.reach), windowTo);
+    entry.starts.reserve(times.size());
+    for (const QDateTime &time : times) {
+        if (time < windowTo) entry.starts.append(time);
+    }
+    ++m_expansions;
+    return entry;
+}
+
+QList<OccurrenceCache::Occurrence> OccurrenceCache::occurrences(const QSharedPointer<CalendarItem> &series,
+                                                                const QDateTime &from, const QDateTime &to,
+                                                                const QList<QSharedPointer<CalendarItem>> &overrides)
+{
+    QList<Occurrence> result;
+    if (!series || !from.isValid() || !to.isValid() || from >= to) return result;
+
+    const Entry &entry = entryFor(*series, from, to);
+    const QDateTime earliest = from.addMSecs(-entry.reach);
+    auto it = std::upper_bound(entry.starts.cbegin(), entry.starts.cend(), earliest);
+    for (; it != entry.starts.cend() && *it < to; ++it) {
+        const QDateTime &start = *it;
+        if (start.addMSecs(entry.reach) <= from) continue;
+        bool replaced = false;
+        for (const QSharedPointer<CalendarItem> &replacement : overrides) {
+            if (replacement->recurrenceId() == start) {
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            result.append({series, start, start.addMSecs(entry.duration), start});
+        }
+    }
+
+    // Overrides show up at their own time, wherever the instance they replace was
+    for (const QSharedPointer<CalendarItem> &replacement : overrides) {
+        QDateTime start = replacement->dtStart();
+        QDateTime end = replacement->dtEndOrDue();
+        if (!start.isValid()) start = end;
+        if (!start.isValid()) continue;
+        if (!end.isValid() || end < start) end = start;
+        const QDateTime reachEnd = replacement->allDay() ? end.addDays(1) : qMax(end, start.addMSecs(1));
+        if (start < to && reachEnd > from) {
+            result.append({replacement, start, end, replacement->recurrenceId()});
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const Occurrence &a, const Occurrence &b) { return a.start < b.start; });
+    return result;
+}
+
+qsizetype OccurrenceCache::memoryFootprint() const
+{
+    qsizetype bytes = m_entries.size() * qsizetype(sizeof(IdTable::Id) + sizeof(Entry));
+    for (const Entry &entry : m_entries) {
+        bytes += entry.starts.capacity() * qsizetype(sizeof(QDateTime));
+    }
+    return bytes;
+}
@@ -0,0 +1,49 @@
+#ifndef OCCURRENCECACHE_H
+#define OCCURRENCECACHE_H
+
+#include "calendaritem.h"
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+
+// Memoized RRULE expansion. For every recurring item it keeps the instance starts of the last window
+// it expanded, with EXDATE/EXRULE already removed, and reuses them for any window inside that one.
+// Entries are keyed by item handle and dropped when the item's revision moves on.
+class OccurrenceCache
+{
+public:
+    struct Occurrence {
+        QSharedPointer<CalendarItem> item; // The series, or the override that replaces this instance
+        QDateTime start;
+        QDateTime end;
+        QDateTime recurrenceId; // Instance start as the series defines it; invalid for single items
+    };
+
+    // Instances of series overlapping [from, to), ordered by start. Overrides replace the instance named by
+    // their RECURRENCE-ID and are reported at their own time, so moved instances land in the right window.
+    QList<Occurrence> occurrences(const QSharedPointer<CalendarItem> &series, const QDateTime &from, const QDateTime &to,
+                                  const QList<QSharedPointer<CalendarItem>> &overrides = {});
+
+    void remove(IdTable::Id item) { m_entries.remove(item); }
+    void clear() { m_entries.clear(); }
+    int size() const { return m_entries.size(); }
+    int expansions() const { return m_expansions; } // Windows that had to be expanded rather than reused
+    qsizetype memoryFootprint() const;
+
+private:
+    struct Entry {
+        quint64 revision = 0;
+        QDateTime from;
+        QDateTime to;
+        QList<QDateTime> starts;
+        qint64 duration = 0; // msecs from an instance start to its end
+        qint64 reach = 0;    // msecs an instance can extend past its start for overlap tests
+    };
+    const Entry &entryFor(const CalendarItem &series, const QDateTime &from, const QDateTime &to);
+
+    QHash<IdTable::Id, Entry> m_entries;
+    int m_expansions = 0;
+};
+
+#endif // OCCURRENCECACHE_H
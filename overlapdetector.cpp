@@ -0,0 +1,262 @@
+#include "overlapdetector.h"
+#include "cal.h"
+#include "collection.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+// Larger batches are cheaper to sweep again than to move into the sorted lists one by one
+constexpr int IncrementalLimit = 64;
+}
+
+OverlapDetector::OverlapDetector(Collection *collection)
+    : QObject(collection), m_collection(collection)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, &QTimer::timeout, this, &OverlapDetector::flush);
+    connect(m_collection, &Collection::calendarsChanged, this, &OverlapDetector::syncCalendars);
+    syncCalendars();
+}
+
+bool OverlapDetector::isDoubleBooked(IdTable::Id itemHandle)
+{
+    flush();
+    return m_flagged.contains(itemHandle);
+}
+
+int OverlapDetector::doubleBookedCount()
+{
+    flush();
+    return m_flagged.size();
+}
+
+void OverlapDetector::syncCalendars()
+{
+    const QList<Cal*> calendars = m_collection->calendars();
+    const QList<Cal*> previous = std::exchange(m_attached, {});
+    for (Cal *cal : previous) {
+        if (!calendars.contains(cal)) disconnect(cal, nullptr, this, nullptr);
+    }
+    for (Cal *cal : calendars) {
+        if (previous.contains(cal)) {
+            m_attached.append(cal);
+        } else {
+            attach(cal);
+        }
+    }
+    scheduleRebuild();
+}
+
+void OverlapDetector::attach(Cal *cal)
+{
+    m_attached.append(cal);
+    connect(cal, &QAbstractItemModel::rowsInserted, this,
+            [this, cal](const QModelIndex &, int first, int last) { itemsChanged(cal, first, last); });
+    connect(cal, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this, cal](const QModelIndex &, int first, int last) { itemsChanged(cal, first, last); });
+    connect(cal, &QAbstractItemModel::dataChanged, this,
+            [this, cal](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+                if (!roles.isEmpty() && !roles.contains(Cal::SortRole)) return; // Flag updates, our own included
+                itemsChanged(cal, topLeft.row(), bottomRight.row());
+            });
+    connect(cal, &QAbstractItemModel::modelReset, this, &OverlapDetector::scheduleRebuild);
+    connect(cal, &QObject::destroyed, this, [this](QObject *object) {
+        m_attached.removeOne(static_cast<Cal*>(object)); // Its spans go with the rebuild
+        scheduleRebuild();
+    });
+}
+
+void OverlapDetector::itemsChanged(Cal *cal, int first, int last)
+{
+    if (m_rebuildPending) return;
+    if (last - first + 1 + m_pending.size() > IncrementalLimit) {
+        scheduleRebuild();
+        return;
+    }
+    // Handles only; removed rows are recognised at the flush by no longer having a row
+    for (int row = first; row <= last; ++row) {
+        m_pending.insert(cal->handleAt(row), cal);
+    }
+    m_flushTimer.start();
+}
+
+void OverlapDetector::scheduleRebuild()
+{
+    m_rebuildPending = true;
+    m_pending.clear();
+    m_flushTimer.start();
+}
+
+void OverlapDetector::catchUp()
+{
+    // Items edited in place since the last flush: any revision above the last check
+    const quint64 latest = CalendarItem::latestRevision();
+    if (latest == m_checkedRevision) return;
+    for (Cal *cal : std::as_const(m_attached)) {
+        const int rows = cal->rowCount();
+        for (int row = 0; row < rows && !m_rebuildPending; ++row) {
+            if (cal->itemAt(row)->revision() > m_checkedRevision && !m_pending.contains(cal->handleAt(row))) {
+                itemsChanged(cal, row, row);
+            }
+        }
+    }
+    m_checkedRevision = latest;
+}
+
+void OverlapDetector::flush()
+{
+    catchUp();
+    m_flushTimer.stop();
+    if (m_rebuildPending) {
+        rebuild();
+        return;
+    }
+    const QHash<IdTable::Id, Cal*> pending = std::exchange(m_pending, {});
+    QHash<IdTable::Id, Cal*> affected;
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        const auto old = m_spanOf.constFind(it.key());
+        if (old != m_spanOf.constEnd()) {
+            const Span span = old.value();
+            collectOverlaps(span, &affected); // Partners it leaves
+            removeSpan(span);
+        }
+        affected.insert(it.key(), it.value());
+        const int row = it.value()->rowOf(it.key());
+        Span span;
+        if (row >= 0 && spanOf(*it.value()->itemAt(row), &span)) {
+            span.handle = it.key();
+            span.cal = it.value();
+            insertSpan(span);
+            collectOverlaps(span, &affected); // Partners it joins
+        }
+    }
+    for (auto it = affected.cbegin(); it != affected.cend(); ++it) {
+        const auto span = m_spanOf.constFind(it.key());
+        setFlag(it.key(), it.value(), span != m_spanOf.constEnd() && partners(span.value()) > 0);
+    }
+}
+
+void OverlapDetector::rebuild()
+{
+    m_rebuildPending = false;
+    m_pending.clear();
+    m_checkedRevision = CalendarItem::latestRevision(); // Everything is read fresh below
+    m_spans.clear();
+    m_spanOf.clear();
+    m_maxDuration = 0;
+    for (Cal *cal : std::as_const(m_attached)) {
+        const int rows = cal->rowCount();
+        for (int row = 0; row < rows; ++row) {
+            Span span;
+            if (!spanOf(*cal->itemAt(row), &span)) continue;
+            span.handle = cal->handleAt(row);
+            span.cal = cal;
+            m_spans.append(span);
+        }
+    }
+    std::sort(m_spans.begin(), m_spans.end(), [](const Span &a, const Span &b) {
+        return a.start != b.start ? a.start < b.start : a.handle < b.handle;
+    });
+    m_ends.resize(m_spans.size());
+    m_spanOf.reserve(m_spans.size());
+
+    // Sweep by start: an event overlaps an earlier one if it starts before the latest end so far,
+    // and a later one if the next start comes before its own end
+    QSet<IdTable::Id> flagged;
+    qint64 latestEnd = std::numeric_limits<qint64>::min();
+    for (int i = 0; i < m_spans.size(); ++i) {
+        const Span &span = m_spans.at(i);
+        if (span.start < latestEnd || (i + 1 < m_spans.size() && m_spans.at(i + 1).start < span.end)) {
+            flagged.insert(span.handle);
+        }
+        latestEnd = qMax(latestEnd, span.end);
+        m_ends[i] = span.end;
+        m_spanOf.insert(span.handle, span);
+        m_maxDuration = qMax(m_maxDuration, span.end - span.start);
+    }
+    std::sort(m_ends.begin(), m_ends.end());
+
+    m_flagged.clear();
+    for (Cal *cal : std::as_const(m_attached)) {
+        const int rows = cal->rowCount();
+        for (int row = 0; row < rows; ++row) {
+            const IdTable::Id handle = cal->handleAt(row);
+            setFlag(handle, cal, flagged.contains(handle));
+        }
+    }
+    ++m_rebuilds;
+    qDebug() << "OverlapDetector: Swept" << m_spans.size() << "events of" << m_collection->id() << "-"
+             << m_flagged.size() << "double-booked";
+}
+
+bool OverlapDetector::spanOf(const CalendarItem &item, Span *span)
+{
+    if (!dynamic_cast<const Event*>(&item) || item.isTransparent() || item.allDay() || item.recurs()) return false;
+    const QDateTime start = item.dtStart();
+    const QDateTime end = item.dtEndOrDue();
+    if (!start.isValid() || !end.isValid() || end <= start) return false; // Instants take no time
+    span->start = start.toMSecsSinceEpoch();
+    span->end = end.toMSecsSinceEpoch();
+    return true;
+}
+
+void OverlapDetector::insertSpan(const Span &span)
+{
+    const auto it = std::lower_bound(m_spans.cbegin(), m_spans.cend(), span, [](const Span &a, const Span &b) {
+        return a.start != b.start ? a.start < b.start : a.handle < b.handle;
+    });
+    m_spans.insert(it - m_spans.cbegin(), span);
+    m_ends.insert(std::lower_bound(m_ends.cbegin(), m_ends.cend(), span.end) - m_ends.cbegin(), span.end);
+    m_spanOf.insert(span.handle, span);
+    m_maxDuration = qMax(m_maxDuration, span.end - span.start); // Only grows until the next rebuild
+}
+
+void OverlapDetector::removeSpan(const Span &span)
+{
+    const auto it = std::lower_bound(m_spans.cbegin(), m_spans.cend(), span, [](const Span &a, const Span &b) {
+        return a.start != b.start ? a.start < b.start : a.handle < b.handle;
+    });
+    if (it != m_spans.cend() && it->handle == span.handle) {
+        m_spans.removeAt(it - m_spans.cbegin());
+    }
+    const auto end = std::lower_bound(m_ends.cbegin(), m_ends.cend(), span.end);
+    if (end != m_ends.cend() && *end == span.end) {
+        m_ends.removeAt(end - m_ends.cbegin());
+    }
+    m_spanOf.remove(span.handle);
+}
+
+void OverlapDetector::collectOverlaps(const Span &span, QHash<IdTable::Id, Cal*> *affected) const
+{
+    // Nothing longer than m_maxDuration exists, so an overlapping event starts after span.start - m_maxDuration
+    auto it = std::upper_bound(m_spans.cbegin(), m_spans.cend(), span.start - m_maxDuration,
+                               [](qint64 value, const Span &other) { return value < other.start; });
+    for (; it != m_spans.cend() && it->start < span.end; ++it) {
+        if (it->end > span.start && it->handle != span.handle) affected->insert(it->handle, it->cal);
+    }
+}
+
+int OverlapDetector::partners(const Span &span) const
+{
+    // Events starting before this one ends, less those that ended by the time it starts, less itself
+    const qsizetype startedBefore = std::lower_bound(m_spans.cbegin(), m_spans.cend(), span.end,
+                                                     [](const Span &other, qint64 value) { return other.start < value; })
+                                    - m_spans.cbegin();
+    const qsizetype endedBefore = std::upper_bound(m_ends.cbegin(), m_ends.cend(), span.start) - m_ends.cbegin();
+    return int(startedBefore - endedBefore - 1);
+}
+
+void OverlapDetector::setFlag(IdTable::Id handle, Cal *cal, bool doubleBooked)
+{
+    if (doubleBooked) {
+        m_flagged.insert(handle);
+    } else {
+        m_flagged.remove(handle);
+    }
+    if (!m_attached.contains(cal)) return; // Left the collection or destroyed
+    const int row = cal->rowOf(handle);
+    if (row >= 0) cal->setDoubleBooked(row, doubleBooked);
+}
@@ -0,0 +1,73 @@
+#ifndef OVERLAPDETECTOR_H
+#define OVERLAPDETECTOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QTimer>
+#include "idtable.h"
+
+class Cal;
+class CalendarItem;
+class Collection;
+
+// Finds double bookings across every calendar of a Collection: opaque timed events whose [start, end)
+// intersects another's. All-day and transparent events, to-dos and recurring series are left out.
+// Results go to CalendarItem::isDoubleBooked() and Cal::DoubleBookedRole, next to the sync ConflictStatus.
+//
+// A full pass sorts the events by start and sweeps once, carrying the latest end seen so far. Afterwards
+// the events stay sorted by start with a sorted list of ends beside it; a changed event is moved in both,
+// and only the events it overlapped before or after the change are re-flagged, each in O(log n).
+// Changes are collected from the calendars' model signals and applied on the next event loop pass,
+// so flag updates never land in the middle of another listener's handling of the same change.
+// Items edited in place emit no signal; those are caught up by revision on the next flush or query.
+class OverlapDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OverlapDetector(Collection *collection);
+
+    // Both apply pending changes first, so they answer for the items as they are now
+    bool isDoubleBooked(IdTable::Id itemHandle);
+    int doubleBookedCount();
+    void flush(); // Applies collected changes now instead of on the next event loop pass
+    int rebuilds() const { return m_rebuilds; }
+
+private:
+    struct Span {
+        qint64 start;
+        qint64 end;
+        IdTable::Id handle;
+        Cal *cal;
+    };
+
+    void syncCalendars();
+    void attach(Cal *cal);
+    void itemsChanged(Cal *cal, int first, int last);
+    void scheduleRebuild();
+    void catchUp();
+    void rebuild();
+    static bool spanOf(const CalendarItem &item, Span *span);
+    void insertSpan(const Span &span);
+    void removeSpan(const Span &span);
+    void collectOverlaps(const Span &span, QHash<IdTable::Id, Cal*> *affected) const;
+    int partners(const Span &span) const; // Other events overlapping span
+    void setFlag(IdTable::Id handle, Cal *cal, bool doubleBooked);
+
+    Collection *m_collection;
+    QList<Cal*> m_attached;
+    QList<Span> m_spans; // Sorted by (start, handle)
+    QList<qint64> m_ends; // The same events' ends, sorted
+    QHash<IdTable::Id, Span> m_spanOf; // Span each event is sorted under, to find it after an edit
+    qint64 m_maxDuration = 0; // Bounds how far before a start an overlapping event can begin
+    QSet<IdTable::Id> m_flagged;
+    QHash<IdTable::Id, Cal*> m_pending; // Items changed since the last flush
+    quint64 m_checkedRevision = 0; // CalendarItem::latestRevision() at the last catch-up
+    bool m_rebuildPending = true;
+    QTimer m_flushTimer;
+    int m_rebuilds = 0;
+};
+
+#endif // OVERLAPDETECTOR_H
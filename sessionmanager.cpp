@@ -33,10 +33,10 @@ void SessionManager::queueDeltaChange(const QString &calId, const QSharedPointer
     entry.userIntent = userIntent;
     entry.itemId = item->id();
     entry.calId = calId;
-    entry.icalData = item->toICal().toUtf8().toBase64();
+    entry.icalData = item->icalData().toBase64();
 
     m_newDeltaChanges.append(entry);
-    QString collectionId = calId.split("_").first();
+    QString collectionId = IdTable::collectionIdOf(calId);
     saveDeltaEntries(collectionId); // Save only the delta entries, no cleanExit flag
     emit changesStaged(m_newDeltaChanges);
 }
@@ -53,26 +53,27 @@ void SessionManager::applyDeltaChanges()
             continue;
         }
 
-        for (const QSharedPointer<CalendarItem> &item : cal->items()) {
-            if (item->id() == entry.itemId) {
-                KCalendarCore::ICalFormat format;
-                KCalendarCore::MemoryCalendar::Ptr tempCal(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
-                QString icalString = QString::fromUtf8(QByteArray::fromBase64(entry.icalData.toLatin1()));
-                if (format.fromString(tempCal, icalString)) {
-                    KCalendarCore::Incidence::Ptr newIncidence = tempCal->incidences().first();
-                    item->setIncidence(newIncidence);
-                    item->setDirty(true);
-                    qDebug() << "SessionManager: Applied" << entry.userIntent << "change to item" << item->id() << "in" << calId;
-                    if (entry.userIntent == "remove") {
-                        cal->removeItem(item);
-                    } else if (entry.userIntent == "add" || entry.userIntent == "modify") {
-                        cal->updateItem(item);
-                    }
-                } else {
-                    qDebug() << "SessionManager: Failed to parse iCal data for" << entry.itemId;
-                }
-                break;
+        QSharedPointer<CalendarItem> item = cal->findItem(entry.itemId);
+        if (!item) {
+            qDebug() << "SessionManager: Item" << entry.itemId << "not in" << calId << "—skipping change";
+            continue;
+        }
+
+        KCalendarCore::ICalFormat format;
+        KCalendarCore::MemoryCalendar::Ptr tempCal(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+        QString icalString = QString::fromUtf8(QByteArray::fromBase64(entry.icalData.toLatin1()));
+        if (format.fromString(tempCal, icalString)) {
+            KCalendarCore::Incidence::Ptr newIncidence = tempCal->incidences().first();
+            item->setIncidence(newIncidence);
+            item->setDirty(true);
+            qDebug() << "SessionManager: Applied" << entry.userIntent << "change to item" << item->id() << "in" << calId;
+            if (entry.userIntent == "remove") {
+                cal->removeItem(item);
+            } else if (entry.userIntent == "add" || entry.userIntent == "modify") {
+                cal->updateItem(item);
             }
+        } else {
+            qDebug() << "SessionManager: Failed to parse iCal data for" << entry.itemId;
         }
     }
 }
@@ -214,10 +215,7 @@ bool SessionManager::ChangeResolver::resolveUnappliedEdit(Cal* cal, const QShare
 {
     if (!cal || !item) return false;
 
-    KCalendarCore::Incidence::Ptr incidence = KCalendarCore::Incidence::Ptr(item->incidence()->clone());
-    incidence->setSummary(newSummary);
-    item->setIncidence(incidence);
-    item->setDirty(true);
+    item->setSummary(newSummary); // Copies the incidence only if a clone still shares it; marks the item dirty
 
     m_session->queueDeltaChange(cal->id(), item, "modify");
     return true;
@@ -0,0 +1,156 @@
+#include "snapshotcache.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+
+namespace {
+const quint32 SnapshotMagic = 0x54425331; // "TBS1"
+const quint32 SnapshotVersion = 4; // 2: header-only entries, 3: RELATED-TO and completion in headers, 4: TRANSP
+// Files modified this close to the snapshot time may have changed again within the same mtime tick
+const qint64 RacyWindowMs = 2000;
+}
+
+SnapshotCache::SnapshotCache(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+
+bool SnapshotCache::load()
+{
+    m_entries.clear();
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "SnapshotCache: No snapshot at" << m_filePath;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != SnapshotMagic || version != SnapshotVersion) {
+        qDebug() << "SnapshotCache: Ignoring snapshot with unknown format at" << m_filePath;
+        return false;
+    }
+
+    QString hashAlgorithm;
+    qint64 savedAt = 0;
+    quint32 count = 0;
+    in >> hashAlgorithm >> savedAt >> count;
+    if (!m_hashAlgorithm.isEmpty() && hashAlgorithm != m_hashAlgorithm) {
+        qDebug() << "SnapshotCache: Snapshot uses" << hashAlgorithm << "but" << m_hashAlgorithm << "is configured—ignoring";
+        return false;
+    }
+
+    m_entries.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.mtime >> entry.size >> entry.versionIdentifier >> entry.incidenceData >> entry.headerData;
+        m_entries.insert(key, entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "SnapshotCache: Snapshot" << m_filePath << "is truncated—ignoring";
+        m_entries.clear();
+        return false;
+    }
+
+    m_hashAlgorithm = hashAlgorithm;
+    m_savedAt = savedAt;
+    qDebug() << "SnapshotCache: Loaded" << m_entries.size() << "entries from" << m_filePath;
+    return true;
+}
+
+bool SnapshotCache::save()
+{
+    // QSaveFile writes to a temporary file and renames, so a crash never leaves a half-written snapshot
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SnapshotCache: Failed to open" << m_filePath << ":" << file.errorString();
+        return false;
+    }
+
+    m_savedAt = QDateTime::currentMSecsSinceEpoch();
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << SnapshotMagic << SnapshotVersion << m_hashAlgorithm << m_savedAt << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const Entry &entry = it.value();
+        out << it.key() << entry.mtime << entry.size << entry.versionIdentifier << entry.incidenceData << entry.headerData;
+    }
+
+    if (!file.commit()) {
+        qWarning() << "SnapshotCache: Failed to write" << m_filePath << ":" << file.errorString();
+        return false;
+    }
+    qDebug() << "SnapshotCache: Saved" << m_entries.size() << "entries to" << m_filePath;
+    return true;
+}
+
+bool SnapshotCache::find(const QString &key, qint64 mtime, qint64 size, Entry *entry) const
+{
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd() || it->mtime != mtime || it->size != size) {
+        return false;
+    }
+    if (it->mtime >= m_savedAt - RacyWindowMs) {
+        return false; // Could have been rewritten after we cached it without changing mtime or size
+    }
+    if (entry) {
+        *entry = it.value();
+    }
+    return true;
+}
+
+void SnapshotCache::insert(const QString &key, const Entry &entry)
+{
+    m_entries.insert(key, entry);
+}
+
+QByteArray SnapshotCache::encodeIncidence(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << incidence;
+    return data;
+}
+
+KCalendarCore::Incidence::Ptr SnapshotCache::decodeIncidence(const QByteArray &data)
+{
+    KCalendarCore::Incidence::Ptr incidence;
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_5);
+    in >> incidence;
+    if (in.status() != QDataStream::Ok) {
+        return KCalendarCore::Incidence::Ptr();
+    }
+    return incidence;
+}
+
+QByteArray SnapshotCache::encodeHeader(const IcsHeaderScanner::Header &header)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << quint8(header.type) << header.uid << header.summary << header.dtStart << header.dtEnd << header.due
+        << header.allDay << header.rrule << header.categories << header.lastModified << header.relatedTo
+        << qint32(header.percentComplete) << header.transparent;
+    return data;
+}
+
+bool SnapshotCache::decodeHeader(const QByteArray &data, IcsHeaderScanner::Header *header)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint8 type = 0;
+    qint32 percentComplete = 0;
+    in >> type >> header->uid >> header->summary >> header->dtStart >> header->dtEnd >> header->due
+       >> header->allDay >> header->rrule >> header->categories >> header->lastModified >> header->relatedTo
+       >> percentComplete >> header->transparent;
+    header->percentComplete = percentComplete;
+    header->type = static_cast<IcsHeaderScanner::Type>(type);
+    return in.status() == QDataStream::Ok && header->isValid();
+}
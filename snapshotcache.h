@@ -0,0 +1,49 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QByteArray>
+#include <KCalendarCore/Incidence>
+#include "icsheaderscanner.h"
+
+// Binary cache of parsed .ics files, keyed by path relative to a backend root.
+// An entry is reused only while the file's mtime and size still match.
+class SnapshotCache
+{
+public:
+    struct Entry {
+        qint64 mtime = 0; // msecs since epoch
+        qint64 size = -1;
+        QString versionIdentifier;
+        QByteArray incidenceData; // Incidence in KCalendarCore's QDataStream form
+        QByteArray headerData;    // IcsHeaderScanner::Header, for files that were only indexed
+    };
+
+    explicit SnapshotCache(const QString &filePath = QString());
+
+    QString filePath() const { return m_filePath; }
+    QString hashAlgorithm() const { return m_hashAlgorithm; }
+    void setHashAlgorithm(const QString &name) { m_hashAlgorithm = name; }
+    int size() const { return m_entries.size(); }
+
+    bool load();
+    bool save();
+
+    // Safe to call concurrently as long as nobody inserts at the same time
+    bool find(const QString &key, qint64 mtime, qint64 size, Entry *entry) const;
+    void insert(const QString &key, const Entry &entry);
+
+    static QByteArray encodeIncidence(const KCalendarCore::Incidence::Ptr &incidence);
+    static KCalendarCore::Incidence::Ptr decodeIncidence(const QByteArray &data);
+    static QByteArray encodeHeader(const IcsHeaderScanner::Header &header);
+    static bool decodeHeader(const QByteArray &data, IcsHeaderScanner::Header *header);
+
+private:
+    QString m_filePath;
+    QString m_hashAlgorithm;
+    qint64 m_savedAt = 0; // When the snapshot was written, msecs since epoch
+    QHash<QString, Entry> m_entries;
+};
+
+#endif // SNAPSHOTCACHE_H
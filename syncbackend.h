@@ -30,10 +30,14 @@ public:
     // New entry point for loading
     virtual void startSync(const QString &collectionId) = 0;
 
-    // New virtual functions for version metadata and deletion
+    // New virtual functions for version metadata and deletion; itemId is the bare UID, as in CalendarItem::id()
     virtual QString fetchItemVersionIdentifier(const QString &calId, const QString &itemId) = 0;
     virtual void removeItem(const QString &calId, const QString &itemId) = 0;
 
+    // Brackets a commit that may span several storeItems calls, so backends can make it durable in one go
+    virtual void beginCommit() {}
+    virtual void endCommit() {}
+
 signals:
     // Existing error signal
     void errorOccurred(const QString &error);
@@ -41,7 +45,14 @@ signals:
     // Modified: itemLoaded signal now passes the versionIdentifier.
     void calendarDiscovered(const QString &collectionId, const CalendarMetadata &calendar);
     void itemLoaded(Cal *cal, QSharedPointer<CalendarItem> item, const QString &versionIdentifier);
+    // Batched variant for backends that stream many items at once; one queued delivery per batch
+    void itemsLoaded(Cal *cal, QList<QSharedPointer<CalendarItem>> items);
     void calendarLoaded(Cal *cal);
+
+    // Change feed for edits made outside the application after the initial load
+    void itemsAdded(const QString &calId, QList<QSharedPointer<CalendarItem>> items);
+    void itemsUpdated(const QString &calId, QList<QSharedPointer<CalendarItem>> items);
+    void itemsRemoved(const QString &calId, const QStringList &itemIds);
     void syncCompleted(const QString &collectionId);
 };
 
@@ -0,0 +1,151 @@
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QTimeZone>
+#include "collection.h"
+#include "freebusy.h"
+
+// "When am I free this month?" over a 100k-item collection: a scan of every item of every calendar,
+// the engine's first query, a repeated query, and the refill after one item is rescheduled.
+// The scan ignores recurrences, so it understates what answering without the engine costs.
+class BenchFreeBusy : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchMonth();
+
+private:
+    static QHash<QDate, QBitArray> scanEveryItem(const Collection &collection, const QDateTime &from,
+                                                 const QDateTime &to);
+
+    Collection *m_collection = nullptr;
+};
+
+namespace {
+
+constexpr int CalendarCount = 4;
+constexpr int ItemsPerCalendar = 25000;
+const QDateTime YearStart(QDate(2025, 1, 1), QTime(0, 0), QTimeZone::utc());
+
+QSharedPointer<CalendarItem> sampleEvent(const QString &calId, int i)
+{
+    KCalendarCore::Event::Ptr incidence(new KCalendarCore::Event);
+    const QString uid = QString("%1-%2").arg(calId).arg(i);
+    incidence->setUid(uid);
+    incidence->setSummary(QString("Meeting %1").arg(i));
+    const QDateTime start = YearStart.addSecs(qint64(i * 7919 % (365 * 24 * 4)) * 15 * 60);
+    if (i % 50 == 0) {
+        incidence->setDtStart(QDateTime(start.date(), QTime(0, 0)));
+        incidence->setDtEnd(QDateTime(start.date(), QTime(0, 0)));
+        incidence->setAllDay(true);
+    } else {
+        incidence->setDtStart(start);
+        incidence->setDtEnd(start.addSecs((30 + i % 4 * 30) * 60));
+    }
+    if (i % 20 == 1) {
+        incidence->setTransparency(KCalendarCore::Event::Transparent);
+    }
+    if (i % 200 == 2) {
+        incidence->recurrence()->setWeekly(1);
+        incidence->recurrence()->setDuration(10);
+    }
+    QSharedPointer<CalendarItem> item(new Event(calId, uid));
+    item->setIncidence(incidence);
+    return item;
+}
+
+} // namespace
+
+void BenchFreeBusy::initTestCase()
+{
+    m_collection = new Collection("colB", "Bench", this);
+    for (int c = 0; c < CalendarCount; ++c) {
+        Cal *cal = new Cal(QString("colB_cal%1").arg(c), QString("Calendar %1").arg(c), m_collection);
+        QList<QSharedPointer<CalendarItem>> items;
+        items.reserve(ItemsPerCalendar);
+        for (int i = 0; i < ItemsPerCalendar; ++i) {
+            items.append(sampleEvent(cal->id(), i));
+        }
+        cal->addItems(items);
+        m_collection->addCal(cal);
+    }
+}
+
+QHash<QDate, QBitArray> BenchFreeBusy::scanEveryItem(const Collection &collection, const QDateTime &from,
+                                                     const QDateTime &to)
+{
+    QHash<QDate, QBitArray> days;
+    for (QDate date = from.date(); date < to.date(); date = date.addDays(1)) {
+        days.insert(date, QBitArray(24 * 60));
+    }
+    const QList<Cal*> calendars = collection.calendars();
+    for (const Cal *cal : calendars) {
+        const QList<QSharedPointer<CalendarItem>> items = cal->items();
+        for (const QSharedPointer<CalendarItem> &item : items) {
+            if (item->isTransparent() || item->recurs()) continue;
+            const QDateTime start = item->dtStart();
+            const QDateTime end = item->allDay() ? item->dtEndOrDue().date().addDays(1).startOfDay(QTimeZone::utc())
+                                                 : item->dtEndOrDue();
+            if (end <= from || start >= to) continue;
+            for (qint64 minute = qMax(from.secsTo(start), qint64(0)) / 60;
+                 minute < qMin(from.secsTo(end), from.secsTo(to)) / 60; ++minute) {
+                days[from.date().addDays(minute / (24 * 60))].setBit(int(minute % (24 * 60)));
+            }
+        }
+    }
+    return days;
+}
+
+void BenchFreeBusy::benchMonth()
+{
+    const QDateTime june(QDate(2025, 6, 1), QTime(0, 0), QTimeZone::utc());
+    const QDateTime july = june.addMonths(1);
+    QElapsedTimer timer;
+
+    timer.start();
+    const QHash<QDate, QBitArray> scanned = scanEveryItem(*m_collection, june, july);
+    const qint64 scanMsecs = timer.elapsed();
+    QCOMPARE(scanned.size(), 30);
+
+    FreeBusy engine(m_collection);
+    engine.setTimeZone(QTimeZone::utc());
+    timer.restart();
+    const QList<FreeBusy::Interval> first = engine.busy(june, july);
+    const qint64 firstMsecs = timer.elapsed();
+    QVERIFY(!first.isEmpty());
+    QCOMPARE(engine.filledDays(), 30);
+
+    QList<FreeBusy::Interval> again;
+    QBENCHMARK {
+        again = engine.busy(june, july);
+    }
+    QCOMPARE(again.size(), first.size());
+    QCOMPARE(engine.filledDays(), 30);
+
+    // Move one timed event by a day: only its old and new day are refilled
+    Cal *cal = m_collection->calendars().first();
+    QSharedPointer<CalendarItem> moved;
+    for (const QSharedPointer<CalendarItem> &item : cal->items()) {
+        if (!item->allDay() && !item->recurs() && !item->isTransparent() && item->dtStart().date() == QDate(2025, 6, 10)
+            && item->dtEndOrDue().date() == QDate(2025, 6, 10)) {
+            moved = QSharedPointer<CalendarItem>(item->clone());
+            break;
+        }
+    }
+    QVERIFY(moved);
+    moved->setDtStart(moved->dtStart().addDays(1));
+    moved->setDtEndOrDue(moved->dtEndOrDue().addDays(1));
+    cal->updateItem(moved);
+    timer.restart();
+    engine.busy(june, july);
+    const qint64 refillMsecs = timer.elapsed();
+    QCOMPARE(engine.filledDays(), 32);
+
+    qInfo().noquote() << QString("%1 items, one month: scan of every item %2 ms, first engine query %3 ms, "
+                                 "query after one edit %4 ms")
+                             .arg(CalendarCount * ItemsPerCalendar).arg(scanMsecs).arg(firstMsecs).arg(refillMsecs);
+}
+
+QTEST_MAIN(BenchFreeBusy)
+#include "bench_freebusy.moc"
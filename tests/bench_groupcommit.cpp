@@ -0,0 +1,139 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include "groupcommitwriter.h"
+
+// Compares the old in-place writes with the group-commit pipeline.
+// Throughput comes from QBENCHMARK; the sync counts in the summary line show what each mode guarantees.
+class BenchGroupCommit : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchCommit_data();
+    void benchCommit();
+    void testCommitReplacesAtomically();
+
+private:
+    static void writeInPlace(const QString &dir, const QList<QByteArray> &payloads);
+    static GroupCommitWriter::Result writeGrouped(const QString &dir, const QList<QByteArray> &payloads,
+                                                  GroupCommitWriter::Durability durability);
+
+    QList<QByteArray> m_payloads;
+};
+
+void BenchGroupCommit::initTestCase()
+{
+    // Roughly the size of a typical single-event .ics
+    for (int i = 0; i < 500; ++i) {
+        m_payloads.append(QByteArray("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nBEGIN:VEVENT\r\nUID:bench-")
+                          + QByteArray::number(i) + "\r\nSUMMARY:" + QByteArray(600, 'x')
+                          + "\r\nDTSTART:20250315T100000Z\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+    }
+}
+
+void BenchGroupCommit::writeInPlace(const QString &dir, const QList<QByteArray> &payloads)
+{
+    for (int i = 0; i < payloads.size(); ++i) {
+        QFile file(QString("%1/%2.ics").arg(dir).arg(i));
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(payloads[i]);
+        }
+    }
+}
+
+GroupCommitWriter::Result BenchGroupCommit::writeGrouped(const QString &dir, const QList<QByteArray> &payloads,
+                                                         GroupCommitWriter::Durability durability)
+{
+    GroupCommitWriter writer(durability);
+    for (int i = 0; i < payloads.size(); ++i) {
+        writer.stage(QString("%1/%2.ics").arg(dir).arg(i), payloads[i]);
+    }
+    return writer.commit();
+}
+
+void BenchGroupCommit::benchCommit_data()
+{
+    QTest::addColumn<int>("mode"); // -1 in place, otherwise a GroupCommitWriter::Durability
+    QTest::addColumn<QString>("guarantee");
+
+    QTest::newRow("in-place") << -1 << "a crash can leave a torn file";
+    QTest::newRow("atomic") << int(GroupCommitWriter::Durability::None) << "old or new file, may be lost on power failure";
+    QTest::newRow("group-sync") << int(GroupCommitWriter::Durability::GroupSync) << "old or new file, durable on return";
+    QTest::newRow("item-sync") << int(GroupCommitWriter::Durability::ItemSync) << "old or new file, durable on return";
+}
+
+void BenchGroupCommit::benchCommit()
+{
+    QFETCH(int, mode);
+    QFETCH(QString, guarantee);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    GroupCommitWriter::Result result;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE { // One pass, so the wall-clock figure below is per commit
+        if (mode < 0) {
+            writeInPlace(dir.path(), m_payloads);
+        } else {
+            result = writeGrouped(dir.path(), m_payloads, GroupCommitWriter::Durability(mode));
+        }
+    }
+    const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+
+    qInfo().noquote() << QString("%1: ~%2 items/s, %3 file syncs + %4 directory syncs per commit; %5")
+                             .arg(QTest::currentDataTag())
+                             .arg(m_payloads.size() * 1000 / elapsed)
+                             .arg(result.fileSyncs).arg(result.directorySyncs).arg(guarantee);
+    if (mode >= 0) {
+        QCOMPARE(result.written, m_payloads.size());
+        QCOMPARE(result.failed, 0);
+        QVERIFY2(result.errorString.isEmpty(), qPrintable(result.errorString));
+    }
+    if (mode == int(GroupCommitWriter::Durability::ItemSync)) {
+        // The baseline pays a file and a directory flush for every item
+        QCOMPARE(result.fileSyncs, m_payloads.size());
+        QCOMPARE(result.directorySyncs, m_payloads.size());
+    }
+}
+
+void BenchGroupCommit::testCommitReplacesAtomically()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString target = dir.filePath("item.ics");
+    {
+        QFile file(target);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("old");
+    }
+
+    GroupCommitWriter writer;
+    QVERIFY(writer.stage(target, "new"));
+    // Staged but not committed: the target still holds the old bytes
+    QFile before(target);
+    QVERIFY(before.open(QIODevice::ReadOnly));
+    QCOMPARE(before.readAll(), QByteArray("old"));
+    before.close();
+
+    const GroupCommitWriter::Result result = writer.commit();
+    QCOMPARE(result.written, 1);
+    QCOMPARE(result.directorySyncs, 1);
+    QFile after(target);
+    QVERIFY(after.open(QIODevice::ReadOnly));
+    QCOMPARE(after.readAll(), QByteArray("new"));
+    QVERIFY(!QFile::exists(GroupCommitWriter::tempPathFor(target)));
+
+    // Discarded groups leave neither the target nor a temp file behind
+    {
+        GroupCommitWriter discarded;
+        QVERIFY(discarded.stage(dir.filePath("never.ics"), "data"));
+    }
+    QVERIFY(!QFile::exists(dir.filePath("never.ics")));
+    QVERIFY(!QFile::exists(GroupCommitWriter::tempPathFor(dir.filePath("never.ics"))));
+}
+
+QTEST_MAIN(BenchGroupCommit)
+#include "bench_groupcommit.moc"
@@ -0,0 +1,90 @@
+#include <QtTest/QtTest>
+#include <QTimeZone>
+#include <functional>
+#include "calendaritem.h"
+#include "legacycalendaritem.h"
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Heap cost per item of the compact CalendarItem against the previous QObject-based one.
+// Both hold the same lazily loaded header, which is how large collections keep their items.
+
+namespace {
+
+qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#else
+    return -1; // No portable allocator statistics; the test then only reports sizeof
+#endif
+}
+
+template<typename Header>
+Header sampleHeader(int i)
+{
+    Header header;
+    header.summary = QString("Meeting %1").arg(i);
+    header.dtStart = QDateTime(QDate(2025, 1, 1), QTime(9, 0), QTimeZone::utc()).addSecs(i * 3600);
+    header.dtEndOrDue = header.dtStart.addSecs(1800);
+    header.categories = QStringList{"Work"};
+    return header;
+}
+
+KCalendarCore::Incidence::Ptr loadNothing(const QString &path)
+{
+    Q_UNUSED(path);
+    return KCalendarCore::Incidence::Ptr();
+}
+
+} // namespace
+
+class BenchItemMemory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchBytesPerItem();
+};
+
+void BenchItemMemory::benchBytesPerItem()
+{
+    const int count = 20000;
+    const QString calId("col0_work");
+    // Same capture as the backend's loaders: the file path
+    const CalendarItem::IncidenceLoader loader = [path = QString("/tmp/work/item.ics")]() { return loadNothing(path); };
+
+    QList<QSharedPointer<Legacy::CalendarItem>> legacy;
+    legacy.reserve(count);
+    qint64 before = heapInUse();
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < count; ++i) {
+            QSharedPointer<Legacy::Event> item(new Legacy::Event(calId, QString("uid-%1").arg(i)));
+            item->setLazyIncidence(sampleHeader<Legacy::CalendarItem::Header>(i), loader);
+            legacy.append(item);
+        }
+    }
+    const qint64 legacyBytes = heapInUse() - before;
+
+    QList<QSharedPointer<CalendarItem>> compact;
+    compact.reserve(count);
+    before = heapInUse();
+    for (int i = 0; i < count; ++i) {
+        QSharedPointer<Event> item = QSharedPointer<Event>::create(calId, QString("uid-%1").arg(i));
+        item->setLazyIncidence(sampleHeader<CalendarItem::Header>(i), loader);
+        compact.append(item);
+    }
+    const qint64 compactBytes = heapInUse() - before;
+
+    qInfo().noquote() << QString("sizeof: legacy %1 bytes, compact %2 bytes").arg(sizeof(Legacy::Event)).arg(sizeof(Event));
+    if (legacyBytes < 0) {
+        QSKIP("Allocator statistics unavailable on this platform");
+    }
+    qInfo().noquote() << QString("heap per item (incl. header strings): legacy %1 bytes, compact %2 bytes")
+                             .arg(legacyBytes / count).arg(compactBytes / count);
+    QVERIFY(compactBytes < legacyBytes);
+}
+
+QTEST_MAIN(BenchItemMemory)
+#include "bench_itemmemory.moc"
@@ -0,0 +1,345 @@
+#include "legacycalendaritem.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QString>
+#include <atomic>
+
+namespace Legacy {
+
+namespace {
+std::atomic<quint64> revisionCounter{0};
+quint64 nextRevision() { return ++revisionCounter; }
+}
+
+CalendarItem::CalendarItem(const QString &calId, const QString &itemId, QObject *parent)
+    : QObject(parent), m_calId(calId), m_itemId(itemId), m_lastModified(QDateTime::currentDateTime()),
+      m_revision(nextRevision())
+{
+}
+
+void CalendarItem::setDirty(bool dirty)
+{
+    m_dirty = dirty;
+    if (dirty) {
+        m_revision = nextRevision();
+    }
+}
+
+KCalendarCore::Incidence::Ptr CalendarItem::incidence() const
+{
+    materialize();
+    return m_incidence;
+}
+
+void CalendarItem::setIncidence(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    m_incidence = incidence;
+    m_loader = nullptr;
+    m_header = Header();
+    m_revision = nextRevision();
+    if (incidence) {
+        m_lastModified = QDateTime::currentDateTime();
+    }
+}
+
+CalendarItem::Header CalendarItem::headerFor(const KCalendarCore::Incidence::Ptr &incidence)
+{
+    Header header;
+    if (!incidence) return header;
+    header.summary = incidence->summary();
+    header.allDay = incidence->allDay();
+    header.categories = incidence->categories();
+    if (incidence->type() == KCalendarCore::IncidenceBase::TypeEvent) {
+        header.dtStart = incidence.staticCast<KCalendarCore::Event>()->dtStart();
+        header.dtEndOrDue = incidence.staticCast<KCalendarCore::Event>()->dtEnd();
+    } else if (incidence->type() == KCalendarCore::IncidenceBase::TypeTodo) {
+        KCalendarCore::Todo::Ptr todo = incidence.staticCast<KCalendarCore::Todo>();
+        header.dtStart = todo->hasStartDate() ? todo->dtStart() : QDateTime();
+        header.dtEndOrDue = todo->hasDueDate() ? todo->dtDue() : QDateTime();
+    }
+    return header;
+}
+
+void CalendarItem::setLazyIncidence(const Header &header, const IncidenceLoader &loader)
+{
+    m_incidence.reset();
+    m_header = header;
+    m_loader = loader;
+    m_revision = nextRevision();
+}
+
+bool CalendarItem::materialize() const
+{
+    if (m_incidence) return true;
+    if (!m_loader) return false;
+    m_incidence = m_loader();
+    if (!m_incidence) {
+        qWarning() << "CalendarItem: Failed to load incidence for" << m_itemId;
+        return false;
+    }
+    return true;
+}
+
+QString CalendarItem::summary() const
+{
+    return m_incidence ? m_incidence->summary() : m_header.summary;
+}
+
+void CalendarItem::setSummary(const QString &summary)
+{
+    if (materialize()) {
+        m_incidence->setSummary(summary);
+        setDirty(true);
+    }
+}
+
+qsizetype CalendarItem::memoryFootprint() const
+{
+    // Rough figure: string payloads are exact, KCalendarCore's private data is a fixed estimate
+    constexpr qsizetype IncidencePrivateCost = 1024; // d-pointer, attendee/alarm/attachment lists, recurrence
+    auto text = [](const QString &s) { return s.capacity() * qsizetype(sizeof(QChar)); };
+    auto list = [&text](const QStringList &l) {
+        qsizetype bytes = l.capacity() * qsizetype(sizeof(QString));
+        for (const QString &s : l) bytes += text(s);
+        return bytes;
+    };
+
+    qsizetype bytes = sizeof(*this) + text(m_calId) + text(m_itemId) + text(m_etag)
+                      + text(m_header.summary) + list(m_header.categories);
+    if (m_loader) bytes += 64; // Captured path and hash
+    if (m_incidence) {
+        bytes += IncidencePrivateCost + text(m_incidence->uid()) + text(m_incidence->summary())
+                 + text(m_incidence->description()) + text(m_incidence->location())
+                 + list(m_incidence->categories());
+    }
+    return bytes;
+}
+
+void CalendarItem::copyIncidenceTo(CalendarItem *clone) const
+{
+    if (m_incidence) {
+        clone->setIncidence(KCalendarCore::Incidence::Ptr(m_incidence->clone()));
+    } else {
+        clone->setLazyIncidence(m_header, m_loader); // Both copies load on demand
+    }
+}
+
+// --- Event ---
+Event::Event(const QString &calId, const QString &itemId, QObject *parent)
+    : CalendarItem(calId, itemId, parent)
+{
+}
+
+QString Event::type() const { return "Event"; }
+
+QVariant Event::data(int role) const
+{
+    if (!m_incidence && !m_loader) return QVariant();
+    if (role == Qt::DisplayRole) return summary();
+    if (role == Qt::UserRole) return dtStart().toString();
+    if (role == Qt::UserRole + 1) return dtEndOrDue().toString();
+    return QVariant();
+}
+
+QString Event::toICal() const
+{
+    if (!materialize()) return QString();
+    KCalendarCore::ICalFormat format;
+    KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    tempCalendar->addIncidence(m_incidence);
+    return format.toString(tempCalendar);
+}
+
+CalendarItem* Event::clone(QObject *parent) const
+{
+    if (!m_incidence && !m_loader) return nullptr;
+    Event *clone = new Event(m_calId, m_itemId.split("_").last(), parent);
+    copyIncidenceTo(clone);
+    clone->setLastModified(m_lastModified);
+    // Replace setEtag with setVersionIdentifier
+    clone->setVersionIdentifier(m_etag);
+    clone->setDirty(m_dirty);
+    clone->setConflictStatus(m_conflictStatus);
+    clone->m_revision = m_revision; // Same content, so the same revision
+    return clone;
+}
+
+
+QDateTime Event::dtStart() const
+{
+    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->dtStart() : m_header.dtStart;
+}
+
+void Event::setDtStart(const QDateTime &dtStart)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Event>()->setDtStart(dtStart);
+        setDirty(true);
+    }
+}
+
+QDateTime Event::dtEndOrDue() const
+{
+    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->dtEnd() : m_header.dtEndOrDue;
+}
+
+void Event::setDtEndOrDue(const QDateTime &dtEndOrDue)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Event>()->setDtEnd(dtEndOrDue);
+        setDirty(true);
+    }
+}
+
+QStringList Event::categories() const
+{
+    return m_incidence ? m_incidence->categories() : m_header.categories;
+}
+
+void Event::setCategories(const QStringList &categories)
+{
+    if (materialize()) {
+        m_incidence->setCategories(categories);
+        setDirty(true);
+    }
+}
+
+QString Event::description() const
+{
+    return materialize() ? m_incidence->description() : QString();
+}
+
+void Event::setDescription(const QString &description)
+{
+    if (materialize()) {
+        m_incidence->setDescription(description);
+        setDirty(true);
+    }
+}
+
+bool Event::allDay() const
+{
+    return m_incidence ? m_incidence.staticCast<KCalendarCore::Event>()->allDay() : m_header.allDay;
+}
+
+void Event::setAllDay(bool allDay)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Event>()->setAllDay(allDay);
+        setDirty(true);
+    }
+}
+
+// --- Todo ---
+Todo::Todo(const QString &calId, const QString &itemUid, QObject *parent)
+    : CalendarItem(calId, itemUid, parent)
+{
+}
+
+QString Todo::type() const { return "Todo"; }
+
+QVariant Todo::data(int role) const
+{
+    if (!m_incidence && !m_loader) return QVariant();
+    if (role == Qt::DisplayRole) return summary();
+    if (role == Qt::UserRole) return m_incidence ? m_incidence.staticCast<KCalendarCore::Todo>()->dtStart().toString()
+                                                 : m_header.dtStart.toString();
+    if (role == Qt::UserRole + 1) return m_incidence ? m_incidence.staticCast<KCalendarCore::Todo>()->dtDue().toString()
+                                                     : m_header.dtEndOrDue.toString();
+    return QVariant();
+}
+
+QString Todo::toICal() const
+{
+    if (!materialize()) return QString();
+    KCalendarCore::ICalFormat format;
+    KCalendarCore::MemoryCalendar::Ptr tempCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    tempCalendar->addIncidence(m_incidence);
+    return format.toString(tempCalendar);
+}
+
+CalendarItem* Todo::clone(QObject *parent) const
+{
+    if (!m_incidence && !m_loader) return nullptr;
+    Todo *clone = new Todo(m_calId, m_itemId.split("_").last(), parent);
+    copyIncidenceTo(clone);
+    clone->setLastModified(m_lastModified);
+    // Replace setEtag with setVersionIdentifier
+    clone->setVersionIdentifier(m_etag);
+    clone->setDirty(m_dirty);
+    clone->setConflictStatus(m_conflictStatus);
+    clone->m_revision = m_revision; // Same content, so the same revision
+    return clone;
+}
+
+
+QDateTime Todo::dtStart() const
+{
+    if (!m_incidence) return m_header.dtStart;
+    return m_incidence.staticCast<KCalendarCore::Todo>()->hasStartDate() ?
+               m_incidence.staticCast<KCalendarCore::Todo>()->dtStart() : QDateTime();
+}
+
+void Todo::setDtStart(const QDateTime &dtStart)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Todo>()->setDtStart(dtStart);
+        setDirty(true);
+    }
+}
+
+QDateTime Todo::dtEndOrDue() const
+{
+    if (!m_incidence) return m_header.dtEndOrDue;
+    return m_incidence.staticCast<KCalendarCore::Todo>()->hasDueDate() ?
+               m_incidence.staticCast<KCalendarCore::Todo>()->dtDue() : QDateTime();
+}
+
+void Todo::setDtEndOrDue(const QDateTime &dtEndOrDue)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Todo>()->setDtDue(dtEndOrDue);
+        setDirty(true);
+    }
+}
+
+QStringList Todo::categories() const
+{
+    return m_incidence ? m_incidence->categories() : m_header.categories;
+}
+
+void Todo::setCategories(const QStringList &categories)
+{
+    if (materialize()) {
+        m_incidence->setCategories(categories);
+        setDirty(true);
+    }
+}
+
+QString Todo::description() const
+{
+    return materialize() ? m_incidence->description() : QString();
+}
+
+void Todo::setDescription(const QString &description)
+{
+    if (materialize()) {
+        m_incidence->setDescription(description);
+        setDirty(true);
+    }
+}
+
+bool Todo::allDay() const
+{
+    return m_incidence ? m_incidence.staticCast<KCalendarCore::Todo>()->allDay() : m_header.allDay;
+}
+
+void Todo::setAllDay(bool allDay)
+{
+    if (materialize()) {
+        m_incidence.staticCast<KCalendarCore::Todo>()->setAllDay(allDay);
+        setDirty(true);
+    }
+}
+
+} // namespace Legacy
@@ -0,0 +1,161 @@
+#ifndef LEGACYCALENDARITEM_H
+#define LEGACYCALENDARITEM_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <KCalendarCore/Incidence>
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+#include <KCalendarCore/Event>  // Added for Event definition
+#include <KCalendarCore/Todo>   // Added for Todo definition
+#include <functional>
+
+// CalendarItem as it was while it still derived from QObject, before the compact layout, copied
+// unchanged into its own namespace so bench_itemmemory measures the real previous layout.
+namespace Legacy {
+
+class CalendarItem : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString id READ id CONSTANT)
+    Q_PROPERTY(KCalendarCore::Incidence::Ptr incidence READ incidence WRITE setIncidence)
+
+public:
+    explicit CalendarItem(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    virtual ~CalendarItem() = default;
+
+    virtual QString id() const { return m_itemId; }
+    virtual QString toICal() const = 0;
+    virtual CalendarItem* clone(QObject *parent = nullptr) const = 0; // Single declaration with default parameter
+
+    QString calId() const { return m_calId; }
+    QDateTime lastModified() const { return m_lastModified; }
+    void setLastModified(const QDateTime &lastModified) { m_lastModified = lastModified; }
+    QString versionIdentifier() const { return m_etag; }
+    void setVersionIdentifier(const QString &id) { m_etag = id; }
+
+    bool isDirty() const { return m_dirty; }
+    void setDirty(bool dirty);
+
+    // Changes whenever the content may have changed; equal revisions mean equal content, also across clones.
+    // Code that edits through incidence() directly must call setDirty(true) afterwards.
+    quint64 revision() const { return m_revision; }
+
+    // Loads the incidence first if the item was created lazily
+    KCalendarCore::Incidence::Ptr incidence() const;
+    void setIncidence(const KCalendarCore::Incidence::Ptr &incidence);
+
+    // What the table view shows; enough to list an item without its incidence
+    struct Header {
+        QString summary;
+        QDateTime dtStart;
+        QDateTime dtEndOrDue;
+        bool allDay = false;
+        QStringList categories;
+    };
+    using IncidenceLoader = std::function<KCalendarCore::Incidence::Ptr()>;
+    static Header headerFor(const KCalendarCore::Incidence::Ptr &incidence);
+
+    // Keep only the header; the loader runs on first access to the full incidence
+    void setLazyIncidence(const Header &header, const IncidenceLoader &loader);
+    bool isMaterialized() const { return !m_incidence.isNull(); }
+    bool materialize() const;
+
+    QString summary() const;
+    void setSummary(const QString &summary);
+
+    // Approximate heap bytes held by this item, including its incidence once loaded
+    qsizetype memoryFootprint() const;
+
+    virtual QString type() const = 0;
+    virtual QVariant data(int role) const = 0;
+
+    // New getters/setters
+    virtual QDateTime dtStart() const = 0;
+    virtual void setDtStart(const QDateTime &dtStart) = 0;
+    virtual QDateTime dtEndOrDue() const = 0; // dtEnd for events, due for todos
+    virtual void setDtEndOrDue(const QDateTime &dtEndOrDue) = 0;
+    virtual QStringList categories() const = 0;
+    virtual void setCategories(const QStringList &categories) = 0;
+    virtual QString description() const = 0;
+    virtual void setDescription(const QString &description) = 0;
+    virtual bool allDay() const = 0;
+    virtual void setAllDay(bool allDay) = 0;
+
+    // Define an enum to track conflict status.
+    enum class ConflictStatus {
+        None,
+        Pending,
+        Resolved
+    };
+
+    // Getter and setter for conflict status.
+    ConflictStatus conflictStatus() const { return m_conflictStatus; }
+    void setConflictStatus(ConflictStatus status) { m_conflictStatus = status; }
+
+protected:
+    ConflictStatus m_conflictStatus = ConflictStatus::None;
+
+
+protected:
+    void copyIncidenceTo(CalendarItem *clone) const;
+
+    QString m_calId;
+    QString m_itemId;
+    mutable KCalendarCore::Incidence::Ptr m_incidence; // Null until materialized in lazy mode
+    Header m_header;
+    IncidenceLoader m_loader;
+    QDateTime m_lastModified;
+    QString m_etag;
+    bool m_dirty = false; // New member to track dirty state
+    quint64 m_revision;
+};
+
+class Event : public CalendarItem
+{
+    Q_OBJECT
+public:
+    explicit Event(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    QString type() const override;
+    QVariant data(int role) const override;
+    QString toICal() const override;
+    CalendarItem* clone(QObject *parent = nullptr) const override;
+
+    QDateTime dtStart() const override;
+    void setDtStart(const QDateTime &dtStart) override;
+    QDateTime dtEndOrDue() const override;
+    void setDtEndOrDue(const QDateTime &dtEndOrDue) override;
+    QStringList categories() const override;
+    void setCategories(const QStringList &categories) override;
+    QString description() const override;
+    void setDescription(const QString &description) override;
+    bool allDay() const override;
+    void setAllDay(bool allDay) override;
+};
+
+class Todo : public CalendarItem
+{
+    Q_OBJECT
+public:
+    explicit Todo(const QString &calId, const QString &itemUid, QObject *parent = nullptr);
+    QString type() const override;
+    QVariant data(int role) const override;
+    QString toICal() const override;
+    CalendarItem* clone(QObject *parent = nullptr) const override;
+
+
+    QDateTime dtStart() const override;
+    void setDtStart(const QDateTime &dtStart) override;
+    QDateTime dtEndOrDue() const override;
+    void setDtEndOrDue(const QDateTime &dtEndOrDue) override;
+    QStringList categories() const override;
+    void setCategories(const QStringList &categories) override;
+    QString description() const override;
+    void setDescription(const QString &description) override;
+    bool allDay() const override;
+    void setAllDay(bool allDay) override;
+};
+
+} // namespace Legacy
+
+#endif // LEGACYCALENDARITEM_H
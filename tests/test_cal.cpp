@@ -0,0 +1,708 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTimeZone>
+#include "cal.h"
+#include "collection.h"
+#include "categoryfilterproxy.h"
+#include "mergedcalendarmodel.h"
+#include "freebusy.h"
+#include "overlapdetector.h"
+#include "calendaritem.h"
+
+class TestCal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testIndexFollowsRemovals();
+    void testAddReplacesSameId();
+    void testBatchOpsNotifyOnce();
+    void testDisplayCacheFollowsRevision();
+    void testItemsInRange();
+    void testRecurringOccurrences();
+    void testSearch();
+    void testCategoryFilter();
+    void testTodoTree();
+    void testClonesShareUntilWritten();
+    void testSerializationFollowsRevision();
+    void testMergedCollectionModel();
+    void testFreeBusy();
+    void testOverlapDetector();
+};
+
+namespace {
+
+// What a test item carries; fields left empty are not set
+struct ItemFields {
+    QString summary;
+    QString location;
+    QStringList categories;
+    QString relatedTo; // Parent UID
+    QDateTime start;
+    int minutes = 0;
+    bool todo = false;
+    int percentComplete = 0; // To-dos only
+};
+
+QSharedPointer<CalendarItem> makeItem(const QString &calId, const QString &uid, const ItemFields &fields = {})
+{
+    KCalendarCore::Incidence::Ptr incidence;
+    QSharedPointer<CalendarItem> item;
+    if (fields.todo) {
+        KCalendarCore::Todo::Ptr todo(new KCalendarCore::Todo);
+        todo->setPercentComplete(fields.percentComplete);
+        incidence = todo;
+        item.reset(new Todo(calId, uid));
+    } else {
+        KCalendarCore::Event::Ptr event(new KCalendarCore::Event);
+        if (fields.start.isValid()) {
+            event->setDtStart(fields.start);
+            event->setDtEnd(fields.start.addSecs(fields.minutes * 60));
+        }
+        incidence = event;
+        item.reset(new Event(calId, uid));
+    }
+    incidence->setUid(uid);
+    if (!fields.summary.isEmpty()) incidence->setSummary(fields.summary);
+    if (!fields.location.isEmpty()) incidence->setLocation(fields.location);
+    if (!fields.categories.isEmpty()) incidence->setCategories(fields.categories);
+    if (!fields.relatedTo.isEmpty()) incidence->setRelatedTo(fields.relatedTo);
+    item->setIncidence(incidence);
+    return item;
+}
+
+QSharedPointer<CalendarItem> timedEvent(const QString &calId, const QString &uid, const QDateTime &start, int minutes)
+{
+    return makeItem(calId, uid, {.start = start, .minutes = minutes});
+}
+
+QStringList idsOf(const QList<QSharedPointer<CalendarItem>> &items)
+{
+    QStringList ids;
+    for (const QSharedPointer<CalendarItem> &item : items) ids.append(item->id());
+    return ids;
+}
+
+} // namespace
+
+void TestCal::testIndexFollowsRemovals()
+{
+    Cal cal("col0_work", "Work");
+    QList<QSharedPointer<CalendarItem>> items;
+    for (int i = 0; i < 6; ++i) {
+        items.append(QSharedPointer<CalendarItem>(new Event(cal.id(), QString("item-%1").arg(i))));
+        cal.addItem(items.last());
+    }
+    QCOMPARE(cal.rowOf("item-4"), 4);
+
+    cal.removeItem(items[1]);
+    cal.removeItem(items[5]);
+    QVERIFY(!cal.findItem("item-1"));
+    QVERIFY(!cal.findItem("item-5"));
+    QCOMPARE(cal.rowCount(), 4);
+    // Every remaining id still points at its own row
+    for (int row = 0; row < cal.rowCount(); ++row) {
+        const QString id = cal.items().at(row)->id();
+        QCOMPARE(cal.rowOf(id), row);
+        QCOMPARE(cal.findItem(id), cal.items().at(row));
+    }
+}
+
+void TestCal::testAddReplacesSameId()
+{
+    Cal cal("col0_work", "Work");
+    cal.addItem(QSharedPointer<CalendarItem>(new Event(cal.id(), "a")));
+    cal.addItem(QSharedPointer<CalendarItem>(new Event(cal.id(), "b")));
+
+    QSignalSpy insertSpy(&cal, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changeSpy(&cal, &QAbstractItemModel::dataChanged);
+    QSharedPointer<CalendarItem> reloaded(new Todo(cal.id(), "a"));
+    cal.addItem(reloaded);
+    QCOMPARE(cal.rowCount(), 2);
+    QCOMPARE(insertSpy.size(), 0);
+    QCOMPARE(changeSpy.size(), 1);
+    QCOMPARE(cal.findItem("a"), reloaded);
+    QCOMPARE(cal.rowOf("a"), 0);
+}
+
+void TestCal::testBatchOpsNotifyOnce()
+{
+    Cal cal("col0_work", "Work");
+    QSignalSpy insertSpy(&cal, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removeSpy(&cal, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy resetSpy(&cal, &QAbstractItemModel::modelReset);
+    QSignalSpy changeSpy(&cal, &QAbstractItemModel::dataChanged);
+
+    QList<QSharedPointer<CalendarItem>> batch;
+    for (int i = 0; i < 100; ++i) {
+        batch.append(QSharedPointer<CalendarItem>(new Event(cal.id(), QString("item-%1").arg(i))));
+    }
+    cal.addItems(batch);
+    QCOMPARE(insertSpy.size(), 1);
+    QCOMPARE(cal.rowCount(), 100);
+
+    // Two replacements and one new item: one dataChanged, one insertion
+    cal.updateItems({QSharedPointer<CalendarItem>(new Todo(cal.id(), "item-3")),
+                     QSharedPointer<CalendarItem>(new Todo(cal.id(), "item-70")),
+                     QSharedPointer<CalendarItem>(new Todo(cal.id(), "item-new"))});
+    QCOMPARE(changeSpy.size(), 1);
+    QCOMPARE(insertSpy.size(), 2);
+    QCOMPARE(cal.rowCount(), 101);
+
+    cal.removeItems({"item-10", "item-11", "item-12"});
+    QCOMPARE(removeSpy.size(), 1);
+    // Scattered rows: one removal per contiguous run, bottom-up, and no reset
+    cal.removeItems({"item-0", "item-50", "item-51", "item-new", "missing"});
+    QCOMPARE(removeSpy.size(), 4);
+    QCOMPARE(removeSpy.at(1).at(1).toInt(), 97); // item-new, the last row
+    QCOMPARE(removeSpy.at(2).at(1).toInt(), 47); // item-50 and item-51, after item-10..12 went
+    QCOMPARE(removeSpy.at(2).at(2).toInt(), 48);
+    QCOMPARE(removeSpy.at(3).at(1).toInt(), 0);
+    QCOMPARE(resetSpy.size(), 0);
+    QCOMPARE(cal.rowCount(), 94);
+    for (int row = 0; row < cal.rowCount(); ++row) {
+        QCOMPARE(cal.rowOf(cal.items().at(row)->id()), row);
+    }
+    QVERIFY(!cal.findItem("item-50"));
+    QCOMPARE(cal.findItem("item-70")->type(), Todo(cal.id(), "x").type());
+}
+
+void TestCal::testDisplayCacheFollowsRevision()
+{
+    Cal cal("col0_work", "Work");
+    KCalendarCore::Event::Ptr incidence(new KCalendarCore::Event);
+    incidence->setUid("a");
+    incidence->setSummary("Before");
+    const QDateTime start(QDate(2025, 3, 15), QTime(10, 0), QTimeZone::utc());
+    incidence->setDtStart(start);
+    QSharedPointer<CalendarItem> item(new Event(cal.id(), "a"));
+    item->setIncidence(incidence);
+    cal.addItem(item);
+
+    QCOMPARE(cal.data(cal.index(0, 1)).toString(), QString("Before"));
+    QCOMPARE(cal.data(cal.index(0, 2)).toString(), start.toString());
+    QCOMPARE(cal.data(cal.index(0, 2), Cal::SortRole).toLongLong(), start.toMSecsSinceEpoch());
+    QCOMPARE(cal.data(cal.index(0, 1), Cal::SortRole).toString(), QString("before"));
+
+    // A new incidence moves the revision on, so the cached row is rebuilt
+    KCalendarCore::Event::Ptr edited(new KCalendarCore::Event(*incidence));
+    edited->setSummary("After");
+    item->setIncidence(edited);
+    QCOMPARE(cal.data(cal.index(0, 1)).toString(), QString("After"));
+}
+
+void TestCal::testItemsInRange()
+{
+    Collection collection("colT", "Time");
+    Cal *work = new Cal("colT_work", "Work", &collection);
+    Cal *home = new Cal("colT_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+
+    const QDateTime monday(QDate(2025, 3, 17), QTime(0, 0), QTimeZone::utc());
+    // A long item that starts before the window must still be found
+    work->addItem(timedEvent(work->id(), "offsite", monday.addDays(-3), 6 * 24 * 60));
+    for (int day = 0; day < 14; ++day) {
+        work->addItem(timedEvent(work->id(), QString("standup-%1").arg(day), monday.addDays(day).addSecs(9 * 3600), 15));
+    }
+    home->addItem(timedEvent(home->id(), "dentist", monday.addDays(1).addSecs(8 * 3600), 60));
+    home->addItem(timedEvent(home->id(), "far-away", monday.addDays(60), 60));
+
+    const QDateTime tuesday = monday.addDays(1);
+    QCOMPARE(idsOf(work->itemsInRange(tuesday, tuesday.addDays(1))), QStringList({"offsite", "standup-1"}));
+    QCOMPARE(idsOf(collection.itemsInRange(tuesday, tuesday.addDays(1))),
+             QStringList({"offsite", "dentist", "standup-1"}));
+    QCOMPARE(collection.itemsInRange(monday, monday.addDays(7)).size(), 1 + 7 + 1);
+    // Half-open: an item ending exactly at the window start is outside it
+    QCOMPARE(idsOf(work->itemsInRange(monday.addSecs(9 * 3600 + 15 * 60), monday.addSecs(10 * 3600))),
+             QStringList({"offsite"}));
+
+    // Editing an item in place moves it in the index on the next query
+    QSharedPointer<CalendarItem> standup = work->findItem("standup-1");
+    standup->setDtStart(monday.addDays(30));
+    standup->setDtEndOrDue(monday.addDays(30).addSecs(900));
+    QCOMPARE(idsOf(work->itemsInRange(tuesday, tuesday.addDays(1))), QStringList({"offsite"}));
+    QCOMPARE(idsOf(work->itemsInRange(monday.addDays(30), monday.addDays(31))), QStringList({"standup-1"}));
+    // Edited spans are merged with the tree's hits in start order
+    QSharedPointer<CalendarItem> earlier = work->findItem("standup-3");
+    earlier->setDtStart(tuesday.addSecs(8 * 3600));
+    earlier->setDtEndOrDue(tuesday.addSecs(8 * 3600 + 900));
+    QCOMPARE(idsOf(work->itemsInRange(tuesday, tuesday.addDays(1))), QStringList({"offsite", "standup-3"}));
+    QVERIFY(work->itemsInRange(monday.addDays(3), monday.addDays(4)).isEmpty()); // Its old span is gone
+
+    work->removeItems({"offsite"});
+    QCOMPARE(idsOf(work->itemsInRange(tuesday, tuesday.addDays(1))), QStringList({"standup-3"}));
+    QCOMPARE(idsOf(work->itemsInRange(monday.addDays(30), monday.addDays(31))), QStringList({"standup-1"}));
+}
+
+void TestCal::testRecurringOccurrences()
+{
+    Cal cal("colR_team", "Team");
+    const QDateTime first(QDate(2025, 3, 3), QTime(10, 0), QTimeZone::utc());
+    KCalendarCore::Event::Ptr weekly(new KCalendarCore::Event);
+    weekly->setUid("standup");
+    weekly->setDtStart(first);
+    weekly->setDtEnd(first.addSecs(3600));
+    weekly->recurrence()->setWeekly(1);
+    weekly->recurrence()->addExDateTime(first.addDays(14)); // No standup on the 17th
+    QSharedPointer<CalendarItem> series(new Event(cal.id(), "standup"));
+    series->setIncidence(weekly);
+
+    // The instance on the 24th moves to Tuesday afternoon
+    KCalendarCore::Event::Ptr moved(new KCalendarCore::Event);
+    moved->setUid("standup");
+    moved->setRecurrenceId(first.addDays(21));
+    moved->setDtStart(first.addDays(22).addSecs(4 * 3600));
+    moved->setDtEnd(first.addDays(22).addSecs(5 * 3600));
+    QSharedPointer<CalendarItem> replacement(new Event(cal.id(), "standup-20250324T100000Z"));
+    replacement->setIncidence(moved);
+    cal.addItems({series, replacement});
+
+    const QDateTime march(QDate(2025, 3, 1), QTime(0, 0), QTimeZone::utc());
+    const QList<OccurrenceCache::Occurrence> occurrences = cal.occurrencesInRange(march, march.addMonths(1));
+    QList<QDateTime> starts;
+    for (const OccurrenceCache::Occurrence &occurrence : occurrences) starts.append(occurrence.start);
+    QCOMPARE(starts, QList<QDateTime>({first, first.addDays(7), first.addDays(22).addSecs(4 * 3600), first.addDays(28)}));
+    QCOMPARE(occurrences.at(2).item, replacement);
+    QCOMPARE(occurrences.at(2).recurrenceId, first.addDays(21));
+    QCOMPARE(occurrences.at(3).end, first.addDays(28).addSecs(3600));
+
+    // Windows inside the expanded one are served from the cache until the series changes
+    OccurrenceCache cache;
+    QCOMPARE(cache.occurrences(series, march, march.addMonths(1)).size(), 4);
+    QCOMPARE(cache.occurrences(series, march.addDays(7), march.addDays(14)).size(), 1);
+    QCOMPARE(cache.expansions(), 1);
+    series->setDtStart(first.addSecs(1800));
+    QCOMPARE(cache.occurrences(series, march.addDays(7), march.addDays(14)).first().start, first.addDays(7).addSecs(1800));
+    QCOMPARE(cache.expansions(), 2);
+}
+
+void TestCal::testSearch()
+{
+    Collection collection("colS", "Search");
+    Cal *work = new Cal("colS_work", "Work", &collection);
+    Cal *home = new Cal("colS_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+
+    work->addItems({makeItem(work->id(), "a", {.summary = "Budget review", .location = "Room 4"}),
+                    makeItem(work->id(), "b", {.summary = "Quarterly budget", .location = "Main office"}),
+                    makeItem(work->id(), "c", {.summary = "Team lunch", .location = "Café Müller"})});
+    home->addItem(makeItem(home->id(), "d", {.summary = "Review the garden budget"}));
+
+    QCOMPARE(idsOf(work->search("budget")), QStringList({"a", "b"}));
+    QCOMPARE(idsOf(work->search("BUD rev")), QStringList({"a"}));
+    QCOMPARE(idsOf(work->search("müller")), QStringList({"c"}));
+    QCOMPARE(idsOf(collection.search("review budg")), QStringList({"a", "d"}));
+    QVERIFY(work->search("budget lunch").isEmpty());
+    QVERIFY(work->search("  ").isEmpty());
+
+    // Later changes reach the index: through the model and through the item itself
+    work->updateItem(makeItem(work->id(), "c", {.summary = "Budget lunch", .location = "Café Müller"}));
+    QCOMPARE(idsOf(work->search("budget lunch")), QStringList({"c"}));
+    work->findItem("a")->setSummary("Planning");
+    QCOMPARE(idsOf(work->search("budget")), QStringList({"b", "c"}));
+    work->removeItems({"b"});
+    QCOMPARE(idsOf(work->search("budget")), QStringList({"c"}));
+
+    // A lazy item is searched by its header without being loaded, and by its description once it is
+    KCalendarCore::Event::Ptr offsite(new KCalendarCore::Event);
+    offsite->setUid("e");
+    offsite->setSummary("Offsite");
+    offsite->setDescription("Bring the projector");
+    QSharedPointer<CalendarItem> lazy(new Event(work->id(), "e"));
+    lazy->setLazyIncidence(CalendarItem::headerFor(offsite), [offsite] { return offsite; });
+    work->addItem(lazy);
+    QCOMPARE(idsOf(work->search("offsite")), QStringList({"e"}));
+    QVERIFY(!lazy->isMaterialized());
+    QCOMPARE(lazy->description(), QString("Bring the projector"));
+    QCOMPARE(idsOf(work->search("projector")), QStringList({"e"}));
+}
+
+void TestCal::testCategoryFilter()
+{
+    Collection collection("colF", "Filter");
+    Cal *work = new Cal("colF_work", "Work", &collection);
+    Cal *home = new Cal("colF_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+
+    work->addItems({makeItem(work->id(), "a", {.categories = {"oncall", "income"}}),
+                    makeItem(work->id(), "b", {.categories = {"OnCall"}}),
+                    makeItem(work->id(), "c", {.categories = {"travel"}}),
+                    makeItem(work->id(), "d")});
+    home->addItem(makeItem(home->id(), "e", {.categories = {"income", "travel"}}));
+
+    QCOMPARE(collection.categoryIndex()->find("ONCALL"), collection.categoryIndex()->find("oncall"));
+    QCOMPARE(idsOf(collection.itemsMatching({{"oncall"}, {}, {}})), QStringList({"a", "b"}));
+    QCOMPARE(idsOf(collection.itemsMatching({{"income"}, {}, {"oncall"}})), QStringList({"e"}));
+    QCOMPARE(idsOf(collection.itemsMatching({{}, {"travel", "income"}, {}})), QStringList({"a", "c", "e"}));
+    QCOMPARE(idsOf(collection.itemsMatching({{}, {}, {"travel", "oncall"}})), QStringList({"d"}));
+    QVERIFY(collection.itemsMatching({{"unheard-of"}, {}, {}}).isEmpty());
+    QCOMPARE(idsOf(collection.itemsMatching({{}, {"travel", "unheard-of"}, {}})), QStringList({"c", "e"}));
+    QCOMPARE(collection.itemsMatching({{}, {}, {"unheard-of"}}).size(), 5);
+    QCOMPARE(collection.categoryIndex()->find("unheard-of"), -1); // Filters never add categories
+
+    CategoryFilterProxy proxy;
+    proxy.setSourceModel(work);
+    QCOMPARE(proxy.rowCount(), 4);
+    proxy.setCategoryFilter({{}, {"oncall"}, {}});
+    QCOMPARE(proxy.rowCount(), 2);
+    // A replaced item is re-evaluated as the model reports the change
+    work->updateItem(makeItem(work->id(), "c", {.categories = {"oncall"}}));
+    QCOMPARE(proxy.rowCount(), 3);
+    QCOMPARE(proxy.mapToSource(proxy.index(2, 0)).row(), work->rowOf("c"));
+    // A category nobody had when the filter was set still matches once an item brings it
+    proxy.setCategoryFilter({{"fresh"}, {}, {}});
+    QCOMPARE(proxy.rowCount(), 0);
+    work->addItem(makeItem(work->id(), "f", {.categories = {"fresh"}}));
+    QCOMPARE(proxy.rowCount(), 1);
+    // A category edited in place on the item sends no model signal; reading the proxy catches it up
+    work->findItem("d")->setCategories({"Fresh"});
+    QCOMPARE(proxy.rowCount(), 1);
+    proxy.data(proxy.index(0, 1));
+    QTRY_COMPARE(proxy.rowCount(), 2);
+    work->findItem("f")->setCategories({});
+    proxy.catchUp();
+    QCOMPARE(proxy.rowCount(), 1);
+    QCOMPARE(proxy.mapToSource(proxy.index(0, 0)).row(), work->rowOf("d"));
+}
+
+void TestCal::testTodoTree()
+{
+    Cal cal("colD_tasks", "Tasks");
+    auto makeTodo = [&cal](const QString &uid, const QString &parentUid, int percent) {
+        return makeItem(cal.id(), uid, {.relatedTo = parentUid, .todo = true, .percentComplete = percent});
+    };
+    // Children arrive before their parents
+    cal.addItems({makeTodo("scan", "receipts", 100), makeTodo("accountant", "taxes", 100),
+                  makeTodo("receipts", "taxes", 40), makeTodo("taxes", "", 0), makeTodo("stray", "missing", 0)});
+    auto handle = [&cal](const QString &uid) { return cal.findItem(uid)->handle(); };
+    auto uids = [&cal](const QList<IdTable::Id> &handles) {
+        QStringList ids;
+        for (IdTable::Id h : handles) ids.append(cal.findItem(h)->id());
+        return ids;
+    };
+
+    const TodoTree &tree = cal.todoTree();
+    QCOMPARE(uids(tree.subtree(handle("taxes"))), QStringList({"taxes", "accountant", "receipts", "scan"}));
+    QCOMPARE(tree.parent(handle("scan")), handle("receipts"));
+    QCOMPARE(tree.depth(handle("scan")), 2);
+    QCOMPARE(tree.orphans(), QSet<IdTable::Id>({handle("stray")}));
+    TodoTree::Rollup rollup = tree.rollup(handle("taxes"));
+    QCOMPARE(rollup.count, 4);
+    QCOMPARE(rollup.completed, 2);
+    QCOMPARE(rollup.percent(), 60);
+
+    // An edit made on the item itself is rolled up at the next query
+    QSharedPointer<CalendarItem> receipts = cal.findItem("receipts");
+    receipts->mutableIncidence().staticCast<KCalendarCore::Todo>()->setPercentComplete(100);
+    QCOMPARE(cal.todoTree().rollup(handle("taxes")).completed, 3);
+
+    // Removing a parent orphans its children; adding the missing parent adopts them
+    cal.removeItem(receipts);
+    QCOMPARE(cal.todoTree().rollup(handle("taxes")).count, 2);
+    QVERIFY(cal.todoTree().orphans().contains(handle("scan")));
+    cal.addItem(makeTodo("missing", "", 0));
+    QCOMPARE(cal.todoTree().parent(handle("stray")), handle("missing"));
+    QVERIFY(!cal.todoTree().orphans().contains(handle("stray")));
+
+    // A RELATED-TO cycle leaves one side unattached instead of looping
+    cal.addItems({makeTodo("ping", "pong", 0), makeTodo("pong", "ping", 0)});
+    const TodoTree &cyclic = cal.todoTree();
+    QVERIFY(!cyclic.parent(handle("ping")) || !cyclic.parent(handle("pong")));
+    QCOMPARE(cyclic.size(), 7);
+}
+
+void TestCal::testClonesShareUntilWritten()
+{
+    KCalendarCore::Event::Ptr incidence(new KCalendarCore::Event);
+    incidence->setUid("shared");
+    incidence->setSummary("Original");
+    QSharedPointer<CalendarItem> item(new Event("colW_work", "shared"));
+    item->setIncidence(incidence);
+
+    // Cloning a batch copies no incidence
+    QList<QSharedPointer<CalendarItem>> clones;
+    for (int i = 0; i < 1000; ++i) {
+        clones.append(QSharedPointer<CalendarItem>(item->clone()));
+    }
+    for (const QSharedPointer<CalendarItem> &clone : std::as_const(clones)) {
+        QVERIFY(clone->incidence() == incidence);
+        QCOMPARE(clone->revision(), item->revision());
+    }
+
+    // Writing one clone gives it its own copy; everyone else keeps the original
+    clones[7]->setSummary("Edited");
+    QCOMPARE(clones.at(7)->summary(), QString("Edited"));
+    QVERIFY(clones.at(7)->incidence() != incidence);
+    QCOMPARE(item->summary(), QString("Original"));
+    QVERIFY(clones.at(8)->incidence() == incidence);
+
+    // Once it is the only holder, an edit happens in place
+    clones.clear();
+    item->setSummary("Renamed");
+    QVERIFY(item->incidence() == incidence);
+    QCOMPARE(incidence->summary(), QString("Renamed"));
+
+    // Writing through mutableIncidence() takes a new revision without a separate setDirty()
+    item->setDirty(false);
+    const quint64 before = item->revision();
+    item->mutableIncidence()->setLocation("Room 2");
+    QVERIFY(item->revision() > before);
+    QVERIFY(item->isDirty());
+}
+
+void TestCal::testSerializationFollowsRevision()
+{
+    KCalendarCore::Event::Ptr incidence(new KCalendarCore::Event);
+    incidence->setUid("serial");
+    incidence->setSummary("Before");
+    incidence->setDtStart(QDateTime(QDate(2024, 5, 1), QTime(9, 0)));
+    QSharedPointer<CalendarItem> item(new Event("colS_work", "serial"));
+    item->setIncidence(incidence);
+
+    // Repeated calls hand back the same buffer
+    const QByteArray first = item->icalData();
+    QVERIFY(first.contains("SUMMARY:Before"));
+    QCOMPARE(item->icalData().constData(), first.constData());
+    QCOMPARE(item->toICal(), QString::fromUtf8(first));
+
+    // A clone reuses the bytes it was cloned with
+    QSharedPointer<CalendarItem> clone(item->clone());
+    QCOMPARE(clone->icalData().constData(), first.constData());
+
+    // Any edit moves the revision on and the next call serializes afresh
+    item->setSummary("After");
+    const QByteArray second = item->icalData();
+    QVERIFY(second.contains("SUMMARY:After"));
+    QVERIFY(!second.contains("SUMMARY:Before"));
+    QCOMPARE(clone->icalData(), first);
+}
+
+void TestCal::testMergedCollectionModel()
+{
+    Collection collection("colM", "Merged");
+    Cal *work = new Cal("colM_work", "Work", &collection);
+    Cal *home = new Cal("colM_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+    const QDateTime monday(QDate(2025, 6, 2), QTime(0, 0), QTimeZone::utc());
+    for (int day = 0; day < 5; ++day) {
+        work->addItem(timedEvent(work->id(), QString("w-%1").arg(day), monday.addDays(day).addSecs(9 * 3600), 30));
+        home->addItem(timedEvent(home->id(), QString("h-%1").arg(day), monday.addDays(day).addSecs(12 * 3600), 30));
+    }
+
+    MergedCalendarModel model(&collection);
+    auto startOf = [&model](int row) { return model.data(model.index(row, 2), Cal::SortRole).toLongLong(); };
+    auto isOrdered = [&model, &startOf] {
+        for (int row = 1; row < model.rowCount(); ++row) {
+            if (startOf(row - 1) > startOf(row)) return false;
+        }
+        return true;
+    };
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.mergedRows(), 0);
+    QCOMPARE(model.itemAt(2)->id(), QString("w-1"));
+    QCOMPARE(model.mergedRows(), 3); // Only as far as asked
+    QCOMPARE(model.data(model.index(1, MergedCalendarModel::CalendarColumn)).toString(), QString("Home"));
+
+    // A new item lands at its place in the merged order
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSharedPointer<CalendarItem> early = timedEvent(home->id(), "early", monday.addDays(1).addSecs(8 * 3600), 30);
+    home->addItem(early);
+    QCOMPARE(inserted.size(), 1);
+    QCOMPARE(inserted.at(0).at(1).toInt(), 2);
+    QCOMPARE(model.itemAt(2), early);
+
+    // A rescheduled item moves instead of resetting the model
+    QSignalSpy moved(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+    work->updateItem(timedEvent(work->id(), "w-0", monday.addDays(3).addSecs(13 * 3600), 30));
+    QCOMPARE(moved.size(), 1);
+    QCOMPARE(reset.size(), 0);
+    QCOMPARE(model.itemAt(8)->id(), QString("w-0"));
+    QCOMPARE(model.rowOf(work, model.itemAt(8)->handle()), 8);
+    QVERIFY(isOrdered());
+
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    const int earlyRow = model.rowOf(home, early->handle());
+    home->removeItem(early);
+    QCOMPARE(removed.size(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), earlyRow);
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.rowOf(home, early->handle()), -1);
+    QVERIFY(isOrdered());
+
+    // A large batch into one calendar merges into its run in one reset
+    QList<QSharedPointer<CalendarItem>> batch;
+    for (int i = 0; i < 100; ++i) {
+        batch.append(timedEvent(home->id(), QString("batch-%1").arg(i), monday.addSecs(qint64(97 - i) * 3571), 10));
+    }
+    home->addItems(batch);
+    QCOMPARE(reset.size(), 1);
+    QCOMPARE(model.rowCount(), 110);
+    QVERIFY(isOrdered());
+
+    // An edit made in place through the setters sends no model signal; reading the model schedules
+    // the catch-up, so the row stays where views last saw it until the next event loop pass
+    const QSharedPointer<CalendarItem> friday = work->findItem("w-4");
+    const int fridayRow = model.rowOf(work, friday->handle());
+    friday->setDtStart(monday.addDays(-1));
+    friday->setDtEndOrDue(monday.addDays(-1).addSecs(1800));
+    QCOMPARE(model.rowOf(work, friday->handle()), fridayRow);
+    QTRY_COMPARE(model.rowOf(work, friday->handle()), 0);
+    QCOMPARE(model.itemAt(0), friday);
+    QCOMPARE(moved.size(), 2);
+    QCOMPARE(reset.size(), 1);
+    QVERIFY(isOrdered());
+}
+
+void TestCal::testFreeBusy()
+{
+    Collection collection("colB", "Busy");
+    Cal *work = new Cal("colB_work", "Work", &collection);
+    Cal *home = new Cal("colB_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+    const QDateTime monday(QDate(2025, 9, 1), QTime(0, 0), QTimeZone::utc());
+    auto at = [&monday](int day, int hour, int minute = 0) { return monday.addDays(day).addSecs(hour * 3600 + minute * 60); };
+
+    QSharedPointer<CalendarItem> meeting = timedEvent(work->id(), "meeting", at(0, 9), 60);
+    work->addItem(meeting);
+    home->addItem(timedEvent(home->id(), "plumber", at(0, 9, 30), 90)); // Overlaps the meeting
+    QSharedPointer<CalendarItem> optional = timedEvent(work->id(), "optional", at(0, 13), 120);
+    optional->mutableIncidence().staticCast<KCalendarCore::Event>()->setTransparency(KCalendarCore::Event::Transparent);
+    work->addItem(optional);
+    KCalendarCore::Event::Ptr review(new KCalendarCore::Event);
+    review->setUid("review");
+    review->setDtStart(at(0, 16));
+    review->setDtEnd(at(0, 16, 30));
+    review->recurrence()->setDaily(1);
+    QSharedPointer<CalendarItem> series(new Event(work->id(), "review"));
+    series->setIncidence(review);
+    work->addItem(series);
+    KCalendarCore::Event::Ptr offsite(new KCalendarCore::Event);
+    offsite->setUid("offsite");
+    offsite->setDtStart(QDateTime(monday.date().addDays(1), QTime(0, 0)));
+    offsite->setDtEnd(QDateTime(monday.date().addDays(1), QTime(0, 0)));
+    offsite->setAllDay(true);
+    QSharedPointer<CalendarItem> allDay(new Event(home->id(), "offsite"));
+    allDay->setIncidence(offsite);
+    home->addItem(allDay);
+
+    FreeBusy freeBusy(&collection, 15);
+    freeBusy.setTimeZone(QTimeZone::utc());
+    auto spans = [](const QList<FreeBusy::Interval> &intervals) {
+        QList<std::pair<QDateTime, QDateTime>> result;
+        for (const FreeBusy::Interval &interval : intervals) result.append({interval.start, interval.end});
+        return result;
+    };
+    QCOMPARE(freeBusy.busySlots(monday.date()).size(), 24 * 4);
+    QCOMPARE(spans(freeBusy.busy(at(0, 0), at(1, 0))),
+             (QList<std::pair<QDateTime, QDateTime>>{{at(0, 9), at(0, 11)}, {at(0, 16), at(0, 16, 30)}}));
+    // The all-day offsite blocks the whole of Tuesday, its review included
+    QCOMPARE(spans(freeBusy.busy(at(0, 16), at(2, 17))),
+             (QList<std::pair<QDateTime, QDateTime>>{{at(0, 16), at(0, 16, 30)}, {at(1, 0), at(2, 0)},
+                                                     {at(2, 16), at(2, 16, 30)}}));
+    QCOMPARE(spans(freeBusy.free(at(0, 8), at(0, 12))),
+             (QList<std::pair<QDateTime, QDateTime>>{{at(0, 8), at(0, 9)}, {at(0, 11), at(0, 12)}}));
+
+    // Rescheduling refills only the day the meeting was and is on
+    const int filled = freeBusy.filledDays();
+    QSharedPointer<CalendarItem> later(meeting->clone());
+    later->setDtStart(at(0, 12));
+    later->setDtEndOrDue(at(0, 12, 30));
+    work->updateItem(later);
+    QCOMPARE(spans(freeBusy.busy(at(0, 0), at(3, 0))).first(), std::make_pair(at(0, 9, 30), at(0, 11)));
+    QCOMPARE(freeBusy.filledDays(), filled + 1);
+
+    // An in-place edit is caught up by revision: the optional block turns opaque
+    optional->mutableIncidence().staticCast<KCalendarCore::Event>()->setTransparency(KCalendarCore::Event::Opaque);
+    QVERIFY(freeBusy.busySlots(monday.date()).testBit(13 * 4));
+    QCOMPARE(freeBusy.filledDays(), filled + 2);
+}
+
+void TestCal::testOverlapDetector()
+{
+    Collection collection("colO", "Overlaps");
+    Cal *work = new Cal("colO_work", "Work", &collection);
+    Cal *home = new Cal("colO_home", "Home", &collection);
+    collection.addCal(work);
+    collection.addCal(home);
+    OverlapDetector *detector = collection.overlapDetector();
+    const QDateTime day(QDate(2025, 10, 6), QTime(0, 0), QTimeZone::utc());
+    auto at = [&day](int hour, int minute = 0) { return day.addSecs(hour * 3600 + minute * 60); };
+
+    QSharedPointer<CalendarItem> meeting = timedEvent(work->id(), "meeting", at(9), 60);
+    QSharedPointer<CalendarItem> plumber = timedEvent(home->id(), "plumber", at(9, 30), 90);
+    QSharedPointer<CalendarItem> lunch = timedEvent(work->id(), "lunch", at(12), 60);
+    QSharedPointer<CalendarItem> nextDoor = timedEvent(work->id(), "next-door", at(13), 60); // Touches lunch only
+    QSharedPointer<CalendarItem> optional = timedEvent(home->id(), "optional", at(12, 30), 30);
+    optional->mutableIncidence().staticCast<KCalendarCore::Event>()->setTransparency(KCalendarCore::Event::Transparent);
+    work->addItems({meeting, lunch, nextDoor});
+    home->addItems({plumber, optional});
+    detector->flush();
+    QCOMPARE(detector->rebuilds(), 1);
+    QVERIFY(meeting->isDoubleBooked());
+    QVERIFY(plumber->isDoubleBooked());
+    QVERIFY(!lunch->isDoubleBooked());
+    QVERIFY(!nextDoor->isDoubleBooked());
+    QVERIFY(!optional->isDoubleBooked());
+    QCOMPARE(work->data(work->index(work->rowOf("meeting"), 1), Cal::DoubleBookedRole).toBool(), true);
+
+    // Moving the plumber away clears both sides without another sweep, one notification per flipped row
+    QSignalSpy workChanges(work, &QAbstractItemModel::dataChanged);
+    QSharedPointer<CalendarItem> later(plumber->clone());
+    later->setDtStart(at(15));
+    later->setDtEndOrDue(at(16));
+    home->updateItem(later);
+    detector->flush();
+    QVERIFY(!meeting->isDoubleBooked());
+    QVERIFY(!later->isDoubleBooked());
+    QCOMPARE(detector->doubleBookedCount(), 0);
+    QCOMPARE(workChanges.size(), 1);
+    QCOMPARE(workChanges.at(0).at(2).value<QList<int>>().first(), int(Cal::DoubleBookedRole));
+
+    // A new item lands on lunch; removing it again clears lunch
+    QSharedPointer<CalendarItem> call = timedEvent(home->id(), "call", at(12, 45), 30);
+    home->addItem(call);
+    detector->flush();
+    QVERIFY(lunch->isDoubleBooked());
+    QVERIFY(call->isDoubleBooked());
+    QVERIFY(nextDoor->isDoubleBooked());
+    home->removeItem(call);
+    detector->flush();
+    QVERIFY(!lunch->isDoubleBooked());
+    QVERIFY(!nextDoor->isDoubleBooked());
+    QCOMPARE(detector->rebuilds(), 1);
+
+    // Edits made in place through the setters send no model signal; the next query catches them up
+    lunch->setDtStart(at(9, 30));
+    lunch->setDtEndOrDue(at(10, 30));
+    QVERIFY(!lunch->isDoubleBooked());
+    QVERIFY(detector->isDoubleBooked(lunch->handle()));
+    QVERIFY(lunch->isDoubleBooked());
+    QVERIFY(meeting->isDoubleBooked());
+    lunch->setDtStart(at(12));
+    lunch->setDtEndOrDue(at(13));
+    detector->flush();
+    QVERIFY(!lunch->isDoubleBooked());
+    QVERIFY(!meeting->isDoubleBooked());
+    QCOMPARE(detector->rebuilds(), 1);
+
+    // A large batch is swept again instead of merged item by item
+    QList<QSharedPointer<CalendarItem>> batch;
+    for (int i = 0; i < 100; ++i) {
+        batch.append(timedEvent(work->id(), QString("slot-%1").arg(i), at(18).addSecs(i * 15 * 60), i == 50 ? 30 : 15));
+    }
+    work->addItems(batch);
+    detector->flush();
+    QCOMPARE(detector->rebuilds(), 2);
+    QCOMPARE(detector->doubleBookedCount(), 2); // The long slot runs into the next one
+    QVERIFY(batch.at(50)->isDoubleBooked());
+    QVERIFY(batch.at(51)->isDoubleBooked());
+}
+
+QTEST_MAIN(TestCal)
+#include "test_cal.moc"
@@ -0,0 +1,131 @@
+#include <QtTest/QtTest>
+#include <QTimeZone>
+#include "icsheaderscanner.h"
+#include "calendaritem.h"
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+
+class TestIcsHeaderScanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testMatchesFullParser_data();
+    void testMatchesFullParser();
+    void testUnfoldingAndEscapes();
+    void testDeclinesWhatItCannotRepresent();
+
+private:
+    static KCalendarCore::Incidence::Ptr parseFully(const QByteArray &ics);
+};
+
+KCalendarCore::Incidence::Ptr TestIcsHeaderScanner::parseFully(const QByteArray &ics)
+{
+    KCalendarCore::ICalFormat format;
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    if (!format.fromString(calendar, QString::fromUtf8(ics)) || calendar->incidences().isEmpty()) {
+        return KCalendarCore::Incidence::Ptr();
+    }
+    return calendar->incidences().first();
+}
+
+void TestIcsHeaderScanner::testMatchesFullParser_data()
+{
+    QTest::addColumn<QByteArray>("ics");
+
+    QTest::newRow("utc event") << QByteArray(
+        "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//TimeBuster//EN\r\n"
+        "BEGIN:VEVENT\r\nUID:utc-1\r\nSUMMARY:Standup\r\nDTSTART:20250315T100000Z\r\n"
+        "DTEND:20250315T103000Z\r\nCATEGORIES:Work,Daily\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+    QTest::newRow("tzid event") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VEVENT\nUID:tz-1\nSUMMARY:Berlin\nDTSTART;TZID=Europe/Berlin:20250315T100000\n"
+        "DTEND;TZID=Europe/Berlin:20250315T110000\nRRULE:FREQ=WEEKLY;COUNT=4\nEND:VEVENT\nEND:VCALENDAR\n");
+    QTest::newRow("all-day event") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VEVENT\nUID:day-1\nSUMMARY:Holiday\nDTSTART;VALUE=DATE:20250315\n"
+        "DTEND;VALUE=DATE:20250317\nEND:VEVENT\nEND:VCALENDAR\n");
+    QTest::newRow("duration event") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VEVENT\nUID:dur-1\nSUMMARY:Workshop\nDTSTART:20250315T090000Z\nDURATION:PT1H30M\n"
+        "END:VEVENT\nEND:VCALENDAR\n");
+    QTest::newRow("todo with alarm") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VTODO\nUID:todo-1\nSUMMARY:File taxes\nDUE:20250415T170000Z\n"
+        "BEGIN:VALARM\nACTION:DISPLAY\nSUMMARY:Alarm text\nTRIGGER:-PT1H\nEND:VALARM\n"
+        "END:VTODO\nEND:VCALENDAR\n");
+    QTest::newRow("subtask in progress") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VTODO\nUID:todo-2\nSUMMARY:Gather receipts\nRELATED-TO:todo-1\n"
+        "RELATED-TO;RELTYPE=SIBLING:todo-3\nPERCENT-COMPLETE:40\nEND:VTODO\nEND:VCALENDAR\n");
+    QTest::newRow("completed subtask") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VTODO\nUID:todo-4\nSUMMARY:Book accountant\nRELATED-TO;RELTYPE=PARENT:todo-1\n"
+        "STATUS:COMPLETED\nCOMPLETED:20250301T120000Z\nEND:VTODO\nEND:VCALENDAR\n");
+    QTest::newRow("transparent event") << QByteArray(
+        "BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+        "BEGIN:VEVENT\nUID:free-1\nSUMMARY:Focus time (optional)\nDTSTART:20250315T130000Z\n"
+        "DTEND:20250315T150000Z\nTRANSP:TRANSPARENT\nEND:VEVENT\nEND:VCALENDAR\n");
+}
+
+void TestIcsHeaderScanner::testMatchesFullParser()
+{
+    QFETCH(QByteArray, ics);
+
+    IcsHeaderScanner::Header header;
+    QVERIFY(IcsHeaderScanner::scan(ics, &header));
+    KCalendarCore::Incidence::Ptr incidence = parseFully(ics);
+    QVERIFY(incidence);
+
+    // The lazy item header built from either source must be identical
+    const CalendarItem::Header expected = CalendarItem::headerFor(incidence);
+    QCOMPARE(header.uid, incidence->uid());
+    QCOMPARE(header.summary, expected.summary);
+    QCOMPARE(header.dtStart, expected.dtStart);
+    QCOMPARE(header.type == IcsHeaderScanner::Type::Todo ? header.due : header.dtEnd, expected.dtEndOrDue);
+    QCOMPARE(header.allDay, expected.allDay);
+    QCOMPARE(header.categories, expected.categories);
+    QCOMPARE(!header.rrule.isEmpty(), incidence->recurs());
+    QCOMPARE(header.relatedTo, expected.relatedTo);
+    QCOMPARE(header.percentComplete, expected.percentComplete);
+    QCOMPARE(header.transparent, expected.transparent);
+}
+
+void TestIcsHeaderScanner::testUnfoldingAndEscapes()
+{
+    const QByteArray ics(
+        "BEGIN:VCALENDAR\r\nVERSION:2.0\r\n"
+        "BEGIN:VEVENT\r\nUID:fold\r\n ed-uid\r\nSUMMARY:Lunch\\, then a long\r\n\t walk\\nhome\r\n"
+        "DESCRIPTION:Skipped without\r\n being unfolded\r\n"
+        "DTSTART;TZID=\"America/New_York\":20250601T120000\r\nDTEND:20250601T170000Z\r\n"
+        "CATEGORIES:Food\\,Drink,Outdoors\r\nCATEGORIES:Personal\r\n"
+        "LAST-MODIFIED:20250501T080000Z\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+
+    IcsHeaderScanner::Header header;
+    QVERIFY(IcsHeaderScanner::scan(ics, &header));
+    QCOMPARE(header.type, IcsHeaderScanner::Type::Event);
+    QCOMPARE(header.uid, QString("folded-uid"));
+    QCOMPARE(header.summary, QString("Lunch, then a long walk\nhome"));
+    QCOMPARE(header.dtStart, QDateTime(QDate(2025, 6, 1), QTime(12, 0), QTimeZone("America/New_York")));
+    QCOMPARE(header.dtStart.toUTC(), QDateTime(QDate(2025, 6, 1), QTime(16, 0), QTimeZone::UTC));
+    QCOMPARE(header.categories, QStringList({"Food,Drink", "Outdoors", "Personal"}));
+    QCOMPARE(header.lastModified, QDateTime(QDate(2025, 5, 1), QTime(8, 0), QTimeZone::UTC));
+}
+
+void TestIcsHeaderScanner::testDeclinesWhatItCannotRepresent()
+{
+    IcsHeaderScanner::Header header;
+    // TZID defined only by the file's own VTIMEZONE
+    QVERIFY(!IcsHeaderScanner::scan("BEGIN:VCALENDAR\nBEGIN:VEVENT\nUID:x\nDTSTART;TZID=My Office:20250101T090000\n"
+                                    "END:VEVENT\nEND:VCALENDAR\n", &header));
+    // More than one item in the file
+    QVERIFY(!IcsHeaderScanner::scan("BEGIN:VCALENDAR\nBEGIN:VEVENT\nUID:a\nEND:VEVENT\n"
+                                    "BEGIN:VEVENT\nUID:a\nRECURRENCE-ID:20250101T090000Z\nEND:VEVENT\nEND:VCALENDAR\n", &header));
+    // Journals are not indexed
+    QVERIFY(!IcsHeaderScanner::scan("BEGIN:VCALENDAR\nBEGIN:VJOURNAL\nUID:j\nEND:VJOURNAL\nEND:VCALENDAR\n", &header));
+    // Truncated inside the item
+    QVERIFY(!IcsHeaderScanner::scan("BEGIN:VCALENDAR\nBEGIN:VEVENT\nUID:t\nSUMMARY:Cut", &header));
+}
+
+QTEST_MAIN(TestIcsHeaderScanner)
+#include "test_icsheaderscanner.moc"
@@ -0,0 +1,74 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QTimeZone>
+#include "icsstreamreader.h"
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+
+class TestIcsStreamReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSplitsIntoSelfContainedCalendars();
+    void testSkipsOversizedComponents();
+};
+
+void TestIcsStreamReader::testSplitsIntoSelfContainedCalendars()
+{
+    QByteArray ics(
+        "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//TimeBuster//EN\r\n"
+        "BEGIN:VTIMEZONE\r\nTZID:Custom/Zone\r\nBEGIN:STANDARD\r\nDTSTART:19700101T000000\r\n"
+        "TZOFFSETFROM:+0130\r\nTZOFFSETTO:+0130\r\nEND:STANDARD\r\nEND:VTIMEZONE\r\n"
+        "BEGIN:VEVENT\r\nUID:a\r\nSUMMARY:First\r\nDTSTART;TZID=Custom/Zone:20250315T100000\r\n"
+        "BEGIN:VALARM\r\nACTION:DISPLAY\r\nTRIGGER:-PT5M\r\nEND:VALARM\r\nEND:VEVENT\r\n"
+        "BEGIN:VFREEBUSY\r\nUID:fb\r\nEND:VFREEBUSY\r\n"
+        "BEGIN:VTODO\r\nUID:b\r\nSUMMARY:Second\r\nEND:VTODO\r\n"
+        "END:VCALENDAR\r\n"
+        // Concatenated exports are common
+        "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nBEGIN:VEVENT\r\nUID:c\r\nSUMMARY:Third\r\n"
+        "DTSTART:20250316T100000Z\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+    QBuffer buffer(&ics);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    IcsStreamReader reader(&buffer);
+
+    QStringList uids;
+    QByteArray piece;
+    while (reader.readNext(&piece)) {
+        KCalendarCore::ICalFormat format;
+        KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+        QVERIFY(format.fromString(calendar, QString::fromUtf8(piece)));
+        QCOMPARE(calendar->incidences().size(), 1);
+        const KCalendarCore::Incidence::Ptr incidence = calendar->incidences().first();
+        uids.append(incidence->uid());
+        if (incidence->uid() == "a") {
+            // The custom zone travelled with the event, and the nested VALARM stayed inside it
+            QVERIFY(piece.contains("TZID:Custom/Zone"));
+            QCOMPARE(incidence->alarms().size(), 1);
+        }
+    }
+    QCOMPARE(uids, QStringList({"a", "b", "c"}));
+    QCOMPARE(reader.componentsRead(), 3);
+    QCOMPARE(reader.componentsSkipped(), 1); // VFREEBUSY
+    QCOMPARE(reader.bytesRead(), qint64(ics.size()));
+}
+
+void TestIcsStreamReader::testSkipsOversizedComponents()
+{
+    QByteArray ics("BEGIN:VCALENDAR\r\nVERSION:2.0\r\n"
+                   "BEGIN:VEVENT\r\nUID:big\r\nDESCRIPTION:" + QByteArray(4096, 'x') + "\r\nEND:VEVENT\r\n"
+                   "BEGIN:VEVENT\r\nUID:small\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+    QBuffer buffer(&ics);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    IcsStreamReader reader(&buffer);
+    reader.setMaxComponentSize(1024);
+
+    QByteArray piece;
+    QVERIFY(reader.readNext(&piece));
+    QVERIFY(piece.contains("UID:small"));
+    QVERIFY(!reader.readNext(&piece));
+    QCOMPARE(reader.componentsSkipped(), 1);
+}
+
+QTEST_MAIN(TestIcsStreamReader)
+#include "test_icsstreamreader.moc"
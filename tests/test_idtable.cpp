@@ -0,0 +1,68 @@
+#include <QtTest/QtTest>
+#include <thread>
+#include "idtable.h"
+#include "calendaritem.h"
+
+class TestIdTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testHierarchy();
+    void testCalendarNamesWithUnderscores();
+    void testConcurrentInterning();
+};
+
+void TestIdTable::testHierarchy()
+{
+    const IdTable::Id cal = IdTable::calendar("colA", "colA_home");
+    const IdTable::Id item = IdTable::item(cal, "uid-1");
+    QCOMPARE(IdTable::item(cal, "uid-1"), item);
+    QCOMPARE(IdTable::findItem(cal, "uid-1"), item);
+    QCOMPARE(IdTable::findItem(cal, "never-seen"), IdTable::Id(0));
+    QCOMPARE(IdTable::text(item), QString("uid-1"));
+    QCOMPARE(IdTable::parent(item), cal);
+    QCOMPARE(IdTable::text(IdTable::parent(cal)), QString("colA"));
+
+    // The same uid in another calendar is a different item
+    const IdTable::Id other = IdTable::calendar("colA", "colA_work");
+    QVERIFY(IdTable::item(other, "uid-1") != item);
+
+    Event event("colA_home", "uid-1");
+    QCOMPARE(event.handle(), item);
+    QCOMPARE(event.calendarHandle(), cal);
+    QCOMPARE(event.calId(), QString("colA_home"));
+    QCOMPARE(event.id(), QString("uid-1"));
+}
+
+void TestIdTable::testCalendarNamesWithUnderscores()
+{
+    // A registered calendar keeps its collection even when the collection id itself contains '_'
+    IdTable::calendar("my_col", "my_col_team_events");
+    QCOMPARE(IdTable::collectionIdOf("my_col_team_events"), QString("my_col"));
+    // An unregistered calendar of a known collection is split after the collection id, not the first '_'
+    QCOMPARE(IdTable::collectionIdOf("my_col_night_shift"), QString("my_col"));
+    IdTable::collection("my_col_night");
+    QCOMPARE(IdTable::collectionIdOf("my_col_night_owls"), QString("my_col_night")); // Longest known prefix wins
+    // Ids of unknown collections fall back to the prefix before the first '_'
+    QCOMPARE(IdTable::collectionIdOf("col7_misc"), QString("col7"));
+}
+
+void TestIdTable::testConcurrentInterning()
+{
+    const IdTable::Id cal = IdTable::calendar("colC", "colC_shared");
+    auto internAll = [cal](QList<IdTable::Id> *ids) {
+        for (int i = 0; i < 2000; ++i) {
+            ids->append(IdTable::item(cal, QString("uid-%1").arg(i)));
+        }
+    };
+    QList<IdTable::Id> first;
+    QList<IdTable::Id> second;
+    std::thread worker(internAll, &first);
+    internAll(&second);
+    worker.join();
+    QCOMPARE(first, second); // Both threads agree on every handle
+}
+
+QTEST_MAIN(TestIdTable)
+#include "test_idtable.moc"
@@ -8,6 +8,13 @@
 #include "calendaritem.h"
 #include <KCalendarCore/ICalFormat>
 #include <KCalendarCore/MemoryCalendar>
+#include <QCryptographicHash>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#if __GLIBC_PREREQ(2, 33)
+#define HAVE_MALLINFO2
+#endif
+#endif
 
 class TestLocalBackend : public QObject
 {
@@ -17,6 +24,15 @@ private slots:
     void initTestCase();
     void testLoadCalendars();
     void testLoadItems();
+    void testParallelLoadMatchesSequential();
+    void testStartSyncDeliversBatches();
+    void testVersionIdentifierFromLoad();
+    void testSnapshotWarmStart();
+    void testWatchReportsExternalEdits();
+    void testLazyLoadingDefersIncidence();
+    void testUnchangedWritesAreElided();
+    void testImportExplodesLargeFile();
+    void testSameUidInTwoCalendars();
 
 private:
     QTemporaryDir tempDir;
@@ -102,10 +118,10 @@ void TestLocalBackend::testLoadItems()
     bool foundEvent = false;
     bool foundTodo = false;
     for (const auto &item : items) {
-        if (item->type() == "Event" && item->id() == "col0_test_calendar_12345") {
+        if (item->type() == "Event" && item->id() == "12345") {
             QCOMPARE(item->incidence()->summary(), QString("Test Event"));
             foundEvent = true;
-        } else if (item->type() == "Todo" && item->id() == "col0_test_calendar_67890") {
+        } else if (item->type() == "Todo" && item->id() == "67890") {
             QCOMPARE(item->incidence()->summary(), QString("Test Todo"));
             foundTodo = true;
         }
@@ -116,5 +132,330 @@ void TestLocalBackend::testLoadItems()
     delete cal; // Clean up
 }
 
+void TestLocalBackend::testParallelLoadMatchesSequential()
+{
+    Cal *cal = new Cal("col0_test_calendar", "Test Calendar", nullptr);
+
+    backend->setLoadWorkerCount(1);
+    QList<QSharedPointer<CalendarItem>> sequential = backend->loadItems(cal);
+
+    backend->setLoadWorkerCount(4);
+    QList<QSharedPointer<CalendarItem>> parallel = backend->loadItems(cal);
+    backend->setLoadWorkerCount(0);
+
+    // Same items, same order, regardless of worker count
+    QCOMPARE(parallel.size(), sequential.size());
+    for (int i = 0; i < sequential.size(); ++i) {
+        QCOMPARE(parallel[i]->id(), sequential[i]->id());
+        QCOMPARE(parallel[i]->incidence()->summary(), sequential[i]->incidence()->summary());
+    }
+
+    delete cal;
+}
+
+void TestLocalBackend::testStartSyncDeliversBatches()
+{
+    backend->setSyncBatchSize(1);
+
+    int batches = 0;
+    QStringList loadedIds;
+    QMetaObject::Connection connection = connect(backend, &SyncBackend::itemsLoaded, this,
+        [&](Cal *cal, QList<QSharedPointer<CalendarItem>> items) {
+            QCOMPARE(cal->id(), QString("col0_test_calendar"));
+            QCOMPARE(QThread::currentThread(), thread());
+            ++batches;
+            for (const auto &item : items) {
+                loadedIds.append(item->id());
+            }
+        });
+    QSignalSpy completedSpy(backend, &SyncBackend::syncCompleted);
+
+    backend->startSync(collectionId);
+    QTRY_COMPARE(completedSpy.count(), 1);
+    disconnect(connection);
+    backend->setSyncBatchSize(500);
+
+    QCOMPARE(batches, 2);
+    loadedIds.sort();
+    QCOMPARE(loadedIds, QStringList({"12345", "67890"}));
+    QVERIFY(!backend->fetchItemVersionIdentifier("col0_test_calendar", "12345").isEmpty());
+}
+
+void TestLocalBackend::testVersionIdentifierFromLoad()
+{
+    QFile eventFile(tempDir.path() + "/Test Calendar/12345.ics");
+    QVERIFY(eventFile.open(QIODevice::ReadOnly));
+    const QByteArray onDisk = eventFile.readAll();
+    eventFile.close();
+
+    Cal *cal = new Cal("col0_test_calendar", "Test Calendar", nullptr);
+    QList<QSharedPointer<CalendarItem>> items = backend->loadItems(cal);
+    QSharedPointer<CalendarItem> event;
+    for (const auto &item : items) {
+        if (item->id() == "12345") event = item;
+    }
+    QVERIFY(event);
+
+    // Carried on the item and matching a fresh hash of the file
+    const QString md5 = QString::fromLatin1(QCryptographicHash::hash(onDisk, QCryptographicHash::Md5).toHex());
+    QCOMPARE(event->versionIdentifier(), md5);
+    QCOMPARE(backend->fetchItemVersionIdentifier(cal->id(), event->id()), md5);
+
+    backend->setHashAlgorithm(ContentHash::Algorithm::XxHash64);
+    items = backend->loadItems(cal);
+    for (const auto &item : items) {
+        if (item->id() == event->id()) {
+            QCOMPARE(item->versionIdentifier(), ContentHash::versionIdentifier(onDisk, ContentHash::Algorithm::XxHash64));
+        }
+    }
+    backend->setHashAlgorithm(ContentHash::Algorithm::Md5);
+
+    // Reference values from the XXH64 specification's test vectors
+    QCOMPARE(ContentHash::xxHash64("", 0), Q_UINT64_C(0xEF46DB3751D8E999));
+    QCOMPARE(ContentHash::versionIdentifier("abc", ContentHash::Algorithm::XxHash64), QString("44bc2cf5ad770999"));
+
+    delete cal;
+}
+
+void TestLocalBackend::testSnapshotWarmStart()
+{
+    // Age the files so they fall outside the snapshot's racy window
+    for (const QString &name : {QString("12345.ics"), QString("67890.ics")}) {
+        QFile file(tempDir.path() + "/Test Calendar/" + name);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(-3600), QFileDevice::FileModificationTime));
+        file.close();
+    }
+
+    const QString snapshotPath = tempDir.path() + "/snapshot.bin";
+    backend->setSnapshotPath(snapshotPath);
+
+    QStringList summaries;
+    QMetaObject::Connection connection = connect(backend, &SyncBackend::itemsLoaded, this,
+        [&](Cal *, QList<QSharedPointer<CalendarItem>> items) {
+            for (const auto &item : items) summaries.append(item->incidence()->summary());
+        });
+
+    // Cold start parses everything and writes the snapshot
+    QSignalSpy coldSpy(backend, &SyncBackend::syncCompleted);
+    backend->startSync(collectionId);
+    QTRY_COMPARE(coldSpy.count(), 1);
+    QCOMPARE(backend->lastSyncSnapshotHits(), 0);
+    QVERIFY(QFile::exists(snapshotPath));
+
+    // Warm start serves both files from the snapshot with identical content
+    const QStringList coldSummaries = summaries;
+    summaries.clear();
+    QSignalSpy warmSpy(backend, &SyncBackend::syncCompleted);
+    backend->startSync(collectionId);
+    QTRY_COMPARE(warmSpy.count(), 1);
+    QCOMPARE(backend->lastSyncSnapshotHits(), 2);
+    QCOMPARE(summaries, coldSummaries);
+
+    disconnect(connection);
+    backend->setSnapshotPath(QString());
+}
+
+void TestLocalBackend::testWatchReportsExternalEdits()
+{
+    backend->setWatchDebounceInterval(50);
+    backend->setWatchEnabled(true);
+    QSignalSpy syncSpy(backend, &SyncBackend::syncCompleted);
+    backend->startSync(collectionId);
+    QTRY_COMPARE(syncSpy.count(), 1);
+
+    QSignalSpy addedSpy(backend, &SyncBackend::itemsAdded);
+    QSignalSpy removedSpy(backend, &SyncBackend::itemsRemoved);
+
+    const QString filePath = tempDir.path() + "/Test Calendar/watched.ics";
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    file.write("BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\n"
+               "BEGIN:VEVENT\nUID:watched\nSUMMARY:Dropped In\nDTSTART:20250316T100000Z\n"
+               "DTEND:20250316T110000Z\nEND:VEVENT\nEND:VCALENDAR\n");
+    file.close();
+
+    QTRY_COMPARE(addedSpy.count(), 1);
+    const auto added = addedSpy.first().at(1).value<QList<QSharedPointer<CalendarItem>>>();
+    QCOMPARE(added.size(), 1);
+    QCOMPARE(added.first()->incidence()->summary(), QString("Dropped In"));
+
+    QVERIFY(QFile::remove(filePath));
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.first().at(1).toStringList(), QStringList{added.first()->id()});
+
+    backend->setWatchEnabled(false);
+}
+
+void TestLocalBackend::testLazyLoadingDefersIncidence()
+{
+    Cal *cal = new Cal("col0_test_calendar", "Test Calendar", nullptr);
+    const QList<QSharedPointer<CalendarItem>> eager = backend->loadItems(cal);
+
+    backend->setLazyLoading(true);
+    const QList<QSharedPointer<CalendarItem>> lazy = backend->loadItems(cal);
+    backend->setLazyLoading(false);
+    QCOMPARE(lazy.size(), eager.size());
+
+    for (int i = 0; i < lazy.size(); ++i) {
+        const auto &item = lazy[i];
+        QVERIFY(!item->isMaterialized());
+        // Table columns come from the header without touching the file
+        QCOMPARE(item->data(Qt::DisplayRole), eager[i]->data(Qt::DisplayRole));
+        QCOMPARE(item->dtStart(), eager[i]->dtStart());
+        QCOMPARE(item->dtEndOrDue(), eager[i]->dtEndOrDue());
+        QVERIFY(!item->isMaterialized());
+    }
+
+    // Serializing loads the incidence
+    QVERIFY(!lazy.first()->toICal().isEmpty());
+    QVERIFY(lazy.first()->isMaterialized());
+    QCOMPARE(lazy.first()->incidence()->uid(), eager.first()->incidence()->uid());
+
+    delete cal;
+
+#ifdef HAVE_MALLINFO2
+    // Measure what the loaded items actually keep on the heap; memoryFootprint() is only an estimate
+    QTemporaryDir heapDir;
+    QVERIFY(heapDir.isValid());
+    QVERIFY(QDir(heapDir.path()).mkdir("Heap"));
+    const QString description = QString("Agenda item. ").repeated(40);
+    for (int i = 0; i < 200; ++i) {
+        QFile file(heapDir.path() + QString("/Heap/heap-%1.ics").arg(i));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QString("BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\nBEGIN:VEVENT\nUID:heap-%1\n"
+                           "SUMMARY:Meeting %1\nDESCRIPTION:%2\nLOCATION:Room %1\nDTSTART:20250315T100000Z\n"
+                           "DTEND:20250315T110000Z\nEND:VEVENT\nEND:VCALENDAR\n").arg(i).arg(description).toUtf8());
+    }
+    LocalBackend heapBackend(heapDir.path());
+    Cal heapCal("col0_heap", "Heap", nullptr);
+    auto retainedBytes = [&heapBackend, &heapCal](bool lazyLoad) {
+        heapBackend.setLazyLoading(lazyLoad);
+        malloc_trim(0);
+        const size_t before = mallinfo2().uordblks;
+        const QList<QSharedPointer<CalendarItem>> items = heapBackend.loadItems(&heapCal);
+        malloc_trim(0);
+        return qint64(mallinfo2().uordblks) - qint64(before);
+    };
+    retainedBytes(false); // Warm-up: interned ids and the backend's path maps are filled once
+    const qint64 eagerHeap = retainedBytes(false);
+    const qint64 lazyHeap = retainedBytes(true);
+    qDebug() << "Heap retained by 200 items: eager" << eagerHeap << "lazy" << lazyHeap;
+    QVERIFY(lazyHeap < eagerHeap);
+#endif
+}
+
+void TestLocalBackend::testUnchangedWritesAreElided()
+{
+    Cal *cal = new Cal("col0_test_calendar", "Test Calendar", nullptr);
+    const QList<QSharedPointer<CalendarItem>> items = backend->loadItems(cal);
+
+    // Nothing touched since loading: no serialization, no write
+    backend->storeItems(cal, items);
+    QCOMPARE(backend->lastCommitResult().written, 0);
+    QCOMPARE(backend->lastCommitElided(), items.size());
+
+    // An edited item is written once; storing it again without further edits is skipped
+    items.first()->setSummary("Edited");
+    backend->storeItems(cal, items);
+    QCOMPARE(backend->lastCommitResult().written, 1);
+    QCOMPARE(backend->lastCommitElided(), items.size() - 1);
+    backend->storeItems(cal, items);
+    QCOMPARE(backend->lastCommitResult().written, 0);
+
+    // Raw updates compare content hashes
+    const QString uid = items.first()->id();
+    const QString ics = items.first()->toICal();
+    backend->updateItem(cal->id(), uid, ics + "\n");
+    QCOMPARE(backend->lastCommitResult().written, 1);
+    backend->updateItem(cal->id(), uid, ics + "\n");
+    QCOMPARE(backend->lastCommitResult().written, 0);
+    QCOMPARE(backend->lastCommitElided(), 1);
+
+    delete cal;
+}
+
+void TestLocalBackend::testImportExplodesLargeFile()
+{
+    QTemporaryDir importDir;
+    QVERIFY(importDir.isValid());
+    const QString sourcePath = importDir.filePath("export.ics");
+    QFile source(sourcePath);
+    QVERIFY(source.open(QIODevice::WriteOnly));
+    source.write("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Test//TimeBuster//EN\r\n");
+    const int count = 250;
+    for (int i = 0; i < count; ++i) {
+        source.write(QString("BEGIN:VEVENT\r\nUID:import-%1\r\nSUMMARY:Imported %1\r\n"
+                             "DTSTART:20250315T100000Z\r\nEND:VEVENT\r\n").arg(i).toUtf8());
+    }
+    // An override of the first event keeps its own id next to the series
+    source.write("BEGIN:VEVENT\r\nUID:import-0\r\nRECURRENCE-ID:20250322T100000Z\r\nSUMMARY:Moved\r\n"
+                 "DTSTART:20250322T120000Z\r\nEND:VEVENT\r\n");
+    // No UID: one is derived from the content and must survive into the written file
+    source.write("BEGIN:VEVENT\r\nSUMMARY:Anonymous\r\nDTSTART:20250323T100000Z\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n");
+    source.close();
+
+    LocalBackend importer(importDir.filePath("root"));
+    importer.setSyncBatchSize(100);
+    importer.setLoadWorkerCount(4);
+    QSignalSpy addedSpy(&importer, &SyncBackend::itemsAdded);
+    QSignalSpy finishedSpy(&importer, &LocalBackend::importFinished);
+    QVERIFY(importer.importIcsFile(sourcePath, CalendarMetadata{"col1_imported", "Imported"}, true));
+    QVERIFY(finishedSpy.wait(10000));
+
+    QCOMPARE(finishedSpy.first().at(1).toInt(), count + 2);
+    QCOMPARE(finishedSpy.first().at(2).toInt(), 0);
+    QCOMPARE(addedSpy.size(), 3); // Batches of 100, 100 and 52
+    QSet<QString> ids;
+    for (const QList<QVariant> &signal : addedSpy) {
+        for (const QSharedPointer<CalendarItem> &item : signal.at(1).value<QList<QSharedPointer<CalendarItem>>>()) {
+            QVERIFY(!item->isDirty());
+            ids.insert(item->id());
+        }
+    }
+    QCOMPARE(ids.size(), count + 2);
+    QVERIFY(ids.contains("import-0-20250322T100000Z"));
+
+    // Every item is now its own file, readable by a normal load under the same id
+    Cal cal("col1_imported", "Imported", nullptr);
+    QSet<QString> loadedIds;
+    for (const QSharedPointer<CalendarItem> &item : importer.loadItems(&cal)) {
+        loadedIds.insert(item->id());
+    }
+    QCOMPARE(loadedIds, ids);
+}
+
+void TestLocalBackend::testSameUidInTwoCalendars()
+{
+    QTemporaryDir rootDir;
+    QVERIFY(rootDir.isValid());
+    const QString ics("BEGIN:VCALENDAR\nVERSION:2.0\nPRODID:-//Test//TimeBuster//EN\nBEGIN:VEVENT\nUID:shared\n"
+                      "SUMMARY:%1\nDTSTART:20250315T100000Z\nEND:VEVENT\nEND:VCALENDAR\n");
+    for (const QString &name : {QString("Home"), QString("Work")}) {
+        QVERIFY(QDir(rootDir.path()).mkdir(name));
+        QFile file(rootDir.path() + "/" + name + "/shared.ics");
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        file.write(ics.arg(name).toUtf8());
+    }
+
+    LocalBackend shared(rootDir.path());
+    Cal home("col2_home", "Home", nullptr);
+    Cal work("col2_work", "Work", nullptr);
+    QCOMPARE(shared.loadItems(&home).size(), 1);
+    QCOMPARE(shared.loadItems(&work).size(), 1);
+    const QString homeVersion = shared.fetchItemVersionIdentifier(home.id(), "shared");
+    const QString workVersion = shared.fetchItemVersionIdentifier(work.id(), "shared");
+    QVERIFY(!homeVersion.isEmpty());
+    QVERIFY(homeVersion != workVersion);
+
+    // Each calendar's copy stays in its own file
+    shared.updateItem(home.id(), "shared", ics.arg("Home edited"));
+    QVERIFY(shared.fetchItemVersionIdentifier(home.id(), "shared") != homeVersion);
+    QCOMPARE(shared.fetchItemVersionIdentifier(work.id(), "shared"), workVersion);
+    shared.removeItem(work.id(), "shared");
+    QVERIFY(QFile::exists(rootDir.path() + "/Home/shared.ics"));
+    QVERIFY(!QFile::exists(rootDir.path() + "/Work/shared.ics"));
+}
+
 QTEST_MAIN(TestLocalBackend)
 #include "test_localbackend.moc"
@@ -0,0 +1,96 @@
+#include "textindex.h"
+#include <algorithm>
+
+QStringList TextIndex::tokenize(const QString &text)
+{
+    QStringList words;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= text.size(); ++i) {
+        const bool wordChar = i < text.size() && text.at(i).isLetterOrNumber();
+        if (wordChar && start < 0) {
+            start = i;
+        } else if (!wordChar && start >= 0) {
+            words.append(text.sliced(start, i - start).toCaseFolded());
+            start = -1;
+        }
+    }
+    return words;
+}
+
+void TextIndex::insert(IdTable::Id item, const QStringList &texts)
+{
+    remove(item);
+    QStringList terms;
+    for (const QString &text : texts) {
+        terms += tokenize(text);
+    }
+    terms.removeDuplicates();
+    for (const QString &term : std::as_const(terms)) {
+        m_postings[term].insert(item);
+    }
+    m_terms.insert(item, terms);
+}
+
+void TextIndex::remove(IdTable::Id item)
+{
+    const auto it = m_terms.constFind(item);
+    if (it == m_terms.constEnd()) return;
+    for (const QString &term : it.value()) {
+        auto posting = m_postings.find(term);
+        if (posting == m_postings.end()) continue;
+        posting->remove(item);
+        if (posting->isEmpty()) m_postings.erase(posting);
+    }
+    m_terms.erase(it);
+}
+
+void TextIndex::clear()
+{
+    m_postings.clear();
+    m_terms.clear();
+}
+
+QSet<IdTable::Id> TextIndex::prefixMatches(const QString &term) const
+{
+    // Words sharing the prefix are contiguous in the sorted map
+    QSet<IdTable::Id> items;
+    for (auto it = m_postings.lowerBound(term); it != m_postings.cend() && it.key().startsWith(term); ++it) {
+        items.unite(it.value());
+    }
+    return items;
+}
+
+QSet<IdTable::Id> TextIndex::search(const QString &query) const
+{
+    QStringList terms = tokenize(query);
+    terms.removeDuplicates();
+    if (terms.isEmpty()) return {};
+    // Longer terms tend to match fewer items; starting with them keeps the running intersection small
+    std::sort(terms.begin(), terms.end(), [](const QString &a, const QString &b) { return a.size() > b.size(); });
+
+    QSet<IdTable::Id> result = prefixMatches(terms.first());
+    for (qsizetype i = 1; i < terms.size() && !result.isEmpty(); ++i) {
+        // Check the few remaining candidates' own words rather than unioning every word with a short prefix
+        const QString &term = terms.at(i);
+        for (auto it = result.begin(); it != result.end();) {
+            const QStringList words = m_terms.value(*it);
+            const bool matches = std::any_of(words.cbegin(), words.cend(),
+                                             [&term](const QString &word) { return word.startsWith(term); });
+            it = matches ? std::next(it) : result.erase(it);
+        }
+    }
+    return result;
+}
+
+qsizetype TextIndex::memoryFootprint() const
+{
+    qsizetype bytes = 0;
+    for (auto it = m_postings.cbegin(); it != m_postings.cend(); ++it) {
+        bytes += it.key().capacity() * qsizetype(sizeof(QChar)) + it.value().capacity() * qsizetype(sizeof(IdTable::Id) * 2);
+    }
+    bytes += m_terms.size() * qsizetype(sizeof(IdTable::Id) + sizeof(QStringList));
+    for (const QStringList &terms : m_terms) {
+        bytes += terms.capacity() * qsizetype(sizeof(QString)); // Word text is shared with the posting keys
+    }
+    return bytes;
+}
@@ -0,0 +1,37 @@
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include "idtable.h"
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+// In-memory inverted index from case-folded words to the items containing them. Words are kept in
+// sorted order so a query term matches every word it is a prefix of; all terms of a query must match.
+// Updated per item, so keeping it current costs one tokenization per changed item.
+class TextIndex
+{
+public:
+    static QStringList tokenize(const QString &text); // Case-folded runs of letters and digits
+
+    void insert(IdTable::Id item, const QStringList &texts); // Replaces what was indexed for the item before
+    void remove(IdTable::Id item);
+    void clear();
+    bool contains(IdTable::Id item) const { return m_terms.contains(item); }
+
+    // Items matching every term of the query, e.g. "budget rev" finds "Budget review"
+    QSet<IdTable::Id> search(const QString &query) const;
+
+    int itemCount() const { return m_terms.size(); }
+    int termCount() const { return m_postings.size(); }
+    qsizetype memoryFootprint() const;
+
+private:
+    QSet<IdTable::Id> prefixMatches(const QString &term) const;
+
+    QMap<QString, QSet<IdTable::Id>> m_postings; // Word -> items
+    QHash<IdTable::Id, QStringList> m_terms;     // Item -> its distinct words, for removal
+};
+
+#endif // TEXTINDEX_H
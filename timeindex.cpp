@@ -0,0 +1,66 @@
+#include "timeindex.h"
+#include <algorithm>
+#include <limits>
+
+void TimeIndex::build(QList<Span> spans)
+{
+    std::stable_sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) { return a.start < b.start; });
+    const int count = spans.size();
+    m_starts.resize(count);
+    m_ends.resize(count);
+    m_maxEnds.resize(count);
+    m_values.resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_starts[i] = spans.at(i).start;
+        m_ends[i] = spans.at(i).end;
+        m_values[i] = spans.at(i).value;
+    }
+    fillMaxEnds(0, count);
+}
+
+void TimeIndex::clear()
+{
+    m_starts.clear();
+    m_ends.clear();
+    m_maxEnds.clear();
+    m_values.clear();
+}
+
+qint64 TimeIndex::fillMaxEnds(int lo, int hi)
+{
+    // The subtree over [lo, hi) is rooted at its midpoint
+    if (lo >= hi) return std::numeric_limits<qint64>::min();
+    const int mid = lo + (hi - lo) / 2;
+    const qint64 maxEnd = std::max({m_ends.at(mid), fillMaxEnds(lo, mid), fillMaxEnds(mid + 1, hi)});
+    m_maxEnds[mid] = maxEnd;
+    return maxEnd;
+}
+
+QList<TimeIndex::Span> TimeIndex::overlapping(qint64 from, qint64 to) const
+{
+    QList<Span> hits;
+    if (from < to) {
+        collect(0, m_values.size(), from, to, &hits);
+    }
+    return hits;
+}
+
+void TimeIndex::collect(int lo, int hi, qint64 from, qint64 to, QList<Span> *hits) const
+{
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (m_maxEnds.at(mid) <= from) return; // Everything below ends before the window
+        collect(lo, mid, from, to, hits);
+        if (m_starts.at(mid) >= to) return; // This span and the right subtree start after the window
+        if (m_ends.at(mid) > from) {
+            hits->append({m_starts.at(mid), m_ends.at(mid), m_values.at(mid)});
+        }
+        lo = mid + 1; // Right subtree without another stack frame
+    }
+}
+
+qsizetype TimeIndex::memoryFootprint() const
+{
+    return (m_starts.capacity() + m_ends.capacity() + m_maxEnds.capacity()) * qsizetype(sizeof(qint64))
+           + m_values.capacity() * qsizetype(sizeof(int));
+}
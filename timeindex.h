@@ -0,0 +1,42 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <QList>
+#include <QtGlobal>
+
+// Static interval index over half-open [start, end) spans in msecs since the epoch. Spans are kept as
+// columns sorted by start, and an implicit balanced tree over that order records the latest end in each
+// subtree, so overlap queries cost O(log n + hits) without touching the items themselves.
+// Built in one go; owners rebuild it after their spans change.
+class TimeIndex
+{
+public:
+    struct Span {
+        qint64 start = 0;
+        qint64 end = 0;
+        int value = 0; // Caller's payload, e.g. a row
+    };
+
+    void build(QList<Span> spans);
+    void clear();
+    int size() const { return m_values.size(); }
+    bool isEmpty() const { return m_values.isEmpty(); }
+
+    // Spans with start < to and end > from, ordered by start
+    QList<Span> overlapping(qint64 from, qint64 to) const;
+    // Spans containing the instant
+    QList<Span> at(qint64 instant) const { return overlapping(instant, instant + 1); }
+
+    qsizetype memoryFootprint() const;
+
+private:
+    qint64 fillMaxEnds(int lo, int hi);
+    void collect(int lo, int hi, qint64 from, qint64 to, QList<Span> *hits) const;
+
+    QList<qint64> m_starts;
+    QList<qint64> m_ends;
+    QList<qint64> m_maxEnds; // Latest end in the subtree rooted at each position
+    QList<int> m_values;
+};
+
+#endif // TIMEINDEX_H
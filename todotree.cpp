@@ -0,0 +1,178 @@
+#include "todotree.h"
+
+void TodoTree::insert(IdTable::Id item, IdTable::Id parent, int percentComplete)
+{
+    if (parent == item) parent = 0; // A to-do cannot be its own parent
+    percentComplete = qBound(0, percentComplete, 100);
+
+    auto it = m_nodes.find(item);
+    if (it == m_nodes.end()) {
+        Node node;
+        node.wanted = parent;
+        node.percent = percentComplete;
+        node.rollup = {1, percentComplete == 100 ? 1 : 0, percentComplete};
+        m_nodes.insert(item, node);
+        adoptWaiting(item);
+        link(item);
+        return;
+    }
+
+    if (it->percent != percentComplete) {
+        const Rollup delta{0, (percentComplete == 100 ? 1 : 0) - (it->percent == 100 ? 1 : 0),
+                           percentComplete - it->percent};
+        it->percent = percentComplete;
+        it->rollup.completed += delta.completed;
+        it->rollup.percentSum += delta.percentSum;
+        addToAncestors(it->parent, delta, 1);
+    }
+    if (it->wanted != parent || (parent && !it->parent)) {
+        detach(item);
+        m_nodes[item].wanted = parent;
+        link(item);
+    }
+    adoptWaiting(item); // An edit may have broken a cycle that kept children waiting
+}
+
+void TodoTree::remove(IdTable::Id item)
+{
+    if (!m_nodes.contains(item)) return;
+    detach(item);
+    // Children stay in the tree as orphans until their parent comes back
+    const QList<IdTable::Id> children = m_nodes.value(item).children;
+    for (IdTable::Id child : children) {
+        detach(child);
+        m_waiting[item].append(child);
+        m_orphans.insert(child);
+    }
+    m_nodes.remove(item);
+}
+
+void TodoTree::clear()
+{
+    m_nodes.clear();
+    m_waiting.clear();
+    m_orphans.clear();
+}
+
+IdTable::Id TodoTree::parent(IdTable::Id item) const
+{
+    const auto it = m_nodes.constFind(item);
+    return it != m_nodes.constEnd() ? it->parent : 0;
+}
+
+QList<IdTable::Id> TodoTree::children(IdTable::Id item) const
+{
+    const auto it = m_nodes.constFind(item);
+    return it != m_nodes.constEnd() ? it->children : QList<IdTable::Id>();
+}
+
+QList<IdTable::Id> TodoTree::roots() const
+{
+    QList<IdTable::Id> roots;
+    for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
+        if (!it->parent) roots.append(it.key());
+    }
+    return roots;
+}
+
+QList<IdTable::Id> TodoTree::subtree(IdTable::Id item) const
+{
+    QList<IdTable::Id> result;
+    if (!m_nodes.contains(item)) return result;
+    result.reserve(m_nodes.value(item).rollup.count);
+    QList<IdTable::Id> stack{item};
+    while (!stack.isEmpty()) {
+        const IdTable::Id current = stack.takeLast();
+        result.append(current);
+        const QList<IdTable::Id> &children = m_nodes.find(current)->children;
+        for (auto child = children.crbegin(); child != children.crend(); ++child) {
+            stack.append(*child); // Reversed so children come out in order
+        }
+    }
+    return result;
+}
+
+TodoTree::Rollup TodoTree::rollup(IdTable::Id item) const
+{
+    const auto it = m_nodes.constFind(item);
+    return it != m_nodes.constEnd() ? it->rollup : Rollup();
+}
+
+int TodoTree::depth(IdTable::Id item) const
+{
+    int depth = 0;
+    for (IdTable::Id current = parent(item); current; current = parent(current)) {
+        ++depth;
+    }
+    return depth;
+}
+
+void TodoTree::attach(IdTable::Id item, IdTable::Id parent)
+{
+    Node &node = m_nodes[item];
+    node.parent = parent;
+    m_nodes[parent].children.append(item);
+    addToAncestors(parent, node.rollup, 1);
+    m_orphans.remove(item);
+}
+
+void TodoTree::detach(IdTable::Id item)
+{
+    Node &node = m_nodes[item];
+    if (!node.parent) {
+        if (node.wanted) {
+            // Not attached but possibly waiting for its parent
+            auto waiting = m_waiting.find(node.wanted);
+            if (waiting != m_waiting.end()) {
+                waiting->removeOne(item);
+                if (waiting->isEmpty()) m_waiting.erase(waiting);
+            }
+        }
+        m_orphans.remove(item);
+        return;
+    }
+    const IdTable::Id parent = node.parent;
+    const Rollup rollup = node.rollup;
+    node.parent = 0;
+    m_nodes[parent].children.removeOne(item);
+    addToAncestors(parent, rollup, -1);
+}
+
+void TodoTree::link(IdTable::Id item)
+{
+    const IdTable::Id wanted = m_nodes.value(item).wanted;
+    if (!wanted) return;
+    if (m_nodes.contains(wanted) && !isInSubtree(wanted, item)) {
+        attach(item, wanted);
+        return;
+    }
+    m_waiting[wanted].append(item);
+    m_orphans.insert(item);
+}
+
+void TodoTree::adoptWaiting(IdTable::Id parent)
+{
+    const QList<IdTable::Id> waiting = m_waiting.take(parent);
+    for (IdTable::Id child : waiting) {
+        m_orphans.remove(child);
+        link(child); // Re-queues itself if attaching would close a cycle
+    }
+}
+
+void TodoTree::addToAncestors(IdTable::Id from, const Rollup &delta, int sign)
+{
+    for (IdTable::Id current = from; current; current = m_nodes.value(current).parent) {
+        Rollup &rollup = m_nodes[current].rollup;
+        rollup.count += sign * delta.count;
+        rollup.completed += sign * delta.completed;
+        rollup.percentSum += sign * delta.percentSum;
+    }
+}
+
+bool TodoTree::isInSubtree(IdTable::Id candidate, IdTable::Id root) const
+{
+    for (IdTable::Id current = candidate; current; current = parent(current)) {
+        if (current == root) return true;
+    }
+    return false;
+}
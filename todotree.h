@@ -0,0 +1,60 @@
+#ifndef TODOTREE_H
+#define TODOTREE_H
+
+#include "idtable.h"
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+// Parent/child index over to-dos linked by RELATED-TO. Every node keeps the size, completed count and
+// summed percentage of its subtree, so roll-ups are O(1) and an insert, edit or removal touches only the
+// node's ancestors. Children naming a parent that is not present (or that would close a cycle) are
+// orphans until that parent arrives.
+class TodoTree
+{
+public:
+    struct Rollup {
+        int count = 0;      // To-dos in the subtree, the root included
+        int completed = 0;
+        qint64 percentSum = 0;
+
+        int percent() const { return count ? int(percentSum / count) : 0; }
+    };
+
+    // Adds or updates a to-do; parent is the RELATED-TO target, 0 for none
+    void insert(IdTable::Id item, IdTable::Id parent, int percentComplete);
+    void remove(IdTable::Id item);
+    void clear();
+
+    bool contains(IdTable::Id item) const { return m_nodes.contains(item); }
+    int size() const { return m_nodes.size(); }
+    IdTable::Id parent(IdTable::Id item) const; // 0 for roots and orphans
+    QList<IdTable::Id> children(IdTable::Id item) const;
+    QList<IdTable::Id> roots() const; // Unattached to-dos, orphans included
+    QSet<IdTable::Id> orphans() const { return m_orphans; }
+    QList<IdTable::Id> subtree(IdTable::Id item) const; // Pre-order, starting with item
+    Rollup rollup(IdTable::Id item) const;
+    int depth(IdTable::Id item) const;
+
+private:
+    struct Node {
+        IdTable::Id parent = 0; // Attached parent
+        IdTable::Id wanted = 0; // Parent named by RELATED-TO
+        int percent = 0;
+        QList<IdTable::Id> children;
+        Rollup rollup;
+    };
+
+    void attach(IdTable::Id item, IdTable::Id parent);
+    void detach(IdTable::Id item);
+    void link(IdTable::Id item); // Attach to the wanted parent, or wait for it
+    void adoptWaiting(IdTable::Id parent);
+    void addToAncestors(IdTable::Id from, const Rollup &delta, int sign);
+    bool isInSubtree(IdTable::Id candidate, IdTable::Id root) const;
+
+    QHash<IdTable::Id, Node> m_nodes;
+    QHash<IdTable::Id, QList<IdTable::Id>> m_waiting; // Wanted parent -> children not attached to it
+    QSet<IdTable::Id> m_orphans;
+};
+
+#endif // TODOTREE_H